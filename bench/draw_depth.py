@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Check that drawing a viewport costs the same at any depth in a tall chunk.
+
+Generates one note of --kb KB, packs it as a single chunk, formats and draws
+it at every scroll step through build_pack.py --format-dry-run, and prints
+texdry's draw cost per slice of the scroll range: the fastest host draw and
+the estimated eZ80 cycles. If tex_draw walked every line above the viewport,
+the deeper slices would cost more. Exits 1 when the deepest slice costs more
+than --max-ratio times the first. Needs what --format-dry-run needs: the
+libtexce submodule and a host C compiler with CMake.
+
+    python3 bench/draw_depth.py
+    python3 bench/draw_depth.py --kb 60 --max-ratio 1.2
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+# A 60 KB chunk still fits one part AppVar next to its header.
+MAX_CHUNK_BYTES = 60 * 1024
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Draw cost against scroll depth on one tall chunk")
+    p.add_argument("--kb", type=int, default=40, help="size of the generated note")
+    p.add_argument("--seed", type=int, default=1)
+    p.add_argument("--max-ratio", type=float, default=1.5, help="allowed deepest/first slice cost")
+    p.add_argument("--texdry", type=Path, help="prebuilt texdry binary (passed to build_pack.py)")
+    p.add_argument("--out", type=Path, help="also write the chunk's dry-run record as JSON")
+    return p.parse_args()
+
+
+def tall_chunk(tmp: Path, args: argparse.Namespace) -> tuple[dict, int]:
+    """The chunk's dry-run record and the viewport height it was drawn in."""
+    gen = [
+        sys.executable,
+        str(ROOT / "tools/gen_corpus.py"),
+        "--out",
+        str(tmp / "corpus"),
+        "--notes",
+        "1",
+        "--seed",
+        str(args.seed),
+        "--size-dist",
+        "fixed",
+        "--mean-bytes",
+        str(args.kb * 1024),
+        "--max-bytes",
+        str(args.kb * 1024),
+        "--utf8",
+        "0",
+    ]
+    subprocess.run(gen, check=True, stdout=subprocess.DEVNULL)
+    manifest = tmp / "pack_manifest.json"
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/build_pack.py"),
+        "--notes-dir",
+        str(tmp / "corpus/n1/notes"),
+        "--out-raw",
+        str(tmp / "raw"),
+        "--manifest",
+        str(manifest),
+        "--skip-8xv",
+        "--no-cache",
+        "--target-bytes",
+        str(MAX_CHUNK_BYTES),
+        "--hard-bytes",
+        str(MAX_CHUNK_BYTES),
+        "--format-dry-run",
+    ]
+    if args.texdry:
+        cmd += ["--texdry", str(args.texdry)]
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+    built = json.loads(manifest.read_text(encoding="utf-8"))
+    chunks = built["notes"][0]["chunks"]
+    return max(chunks, key=lambda c: c.get("text_bytes", 0)), built["format_dry_run"]["viewport"]
+
+
+def main() -> int:
+    args = parse_args()
+    if args.kb * 1024 > MAX_CHUNK_BYTES:
+        print(f"draw_depth: --kb {args.kb} does not fit one chunk ({MAX_CHUNK_BYTES // 1024} KB max)", file=sys.stderr)
+        return 2
+    with tempfile.TemporaryDirectory(prefix="draw_depth_") as tmp:
+        try:
+            rec, viewport = tall_chunk(Path(tmp), args)
+        except subprocess.CalledProcessError as e:
+            print(f"draw_depth: build failed: {e}", file=sys.stderr)
+            return 1
+    if not rec.get("ok") or "draw_us_by_depth" not in rec:
+        print(f"draw_depth: no draw profile for the chunk: {rec.get('error', 'texdry too old?')}", file=sys.stderr)
+        return 1
+    if args.out:
+        args.out.write_text(json.dumps(rec, indent=2), encoding="utf-8")
+
+    us = rec["draw_us_by_depth"]
+    cyc = rec["est_draw_cycles_by_depth"]
+    depth = max(rec["height"] - viewport, 0)
+    print(f"chunk: {rec['text_bytes']} bytes, {rec['height']} px tall")
+    print(f"{'slice':>5} {'from px':>8} {'draw us':>8} {'est cycles':>11}")
+    for i, (u, c) in enumerate(zip(us, cyc)):
+        print(f"{i:>5} {depth * i // len(us):>8} {u:>8} {c:>11}")
+
+    filled = [i for i, c in enumerate(cyc) if c]
+    if len(filled) < 2:
+        print("draw_depth: chunk is too short to compare slices", file=sys.stderr)
+        return 1
+    first, last = filled[0], filled[-1]
+    ratios = {
+        "est cycles": cyc[last] / cyc[first],
+        "draw us": us[last] / max(us[first], 1),
+    }
+    print(", ".join(f"{k} deepest/first: {v:.2f}" for k, v in ratios.items()))
+    worst = max(ratios.values())
+    if worst > args.max_ratio:
+        print(f"draw_depth: drawing gets slower with depth ({worst:.2f} > {args.max_ratio})", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
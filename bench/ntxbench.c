@@ -0,0 +1,320 @@
+/* ntxbench: micro-benchmarks for the pack reader (viewer/src/ntx_pack.c)
+ * against the mmap-backed fileioc stand-in. Results are written as JSON so
+ * runs can be diffed; see bench/run_bench.py. */
+
+#include "ntx_pack.h"
+
+#include <fileioc.h>
+#include <host_alloc.h>
+#include <host_stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_ITERS 100000U
+
+typedef struct
+{
+	const char* vars;
+	const char* index_name;
+	const char* out_path;
+	const char* label;
+	unsigned int iters;
+	unsigned int cold_iters;
+} BenchOptions;
+
+typedef struct
+{
+	uint64_t* samples;
+	unsigned int count;
+	uint64_t allocs;
+	uint64_t alloc_bytes;
+	size_t peak_bytes;
+	uint64_t opens;
+	uint64_t read_bytes;
+	bool ok;
+} BenchRun;
+
+typedef bool (*BenchFn)(void* user);
+
+static int cmp_u64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static bool run_bench(BenchFn fn, void* user, unsigned int iters, bool cold, BenchRun* out)
+{
+	memset(out, 0, sizeof(*out));
+	out->samples = (uint64_t*)calloc(iters, sizeof(uint64_t));
+	if (!out->samples)
+		return false;
+	out->ok = true;
+
+	const size_t base_live = host_alloc_stats().live_bytes;
+	for (unsigned int i = 0; i < iters; ++i)
+	{
+		if (cold)
+			host_fileioc_drop_cache();
+
+		host_stats_reset();
+		host_alloc_reset_peak();
+		const uint64_t t0 = host_now_ns();
+		bool ok = fn(user);
+		const uint64_t t1 = host_now_ns();
+		const HostAllocStats a = host_alloc_stats();
+
+		out->samples[out->count++] = t1 - t0;
+		out->allocs += a.alloc_count;
+		out->alloc_bytes += a.alloc_bytes;
+		if (a.peak_bytes - base_live > out->peak_bytes)
+			out->peak_bytes = a.peak_bytes - base_live;
+		out->opens += host_op_stats[HOST_OP_TI_OPEN].calls;
+		out->read_bytes += host_op_stats[HOST_OP_TI_READ].pixels;
+		if (!ok)
+		{
+			out->ok = false;
+			break;
+		}
+	}
+	qsort(out->samples, out->count, sizeof(uint64_t), cmp_u64);
+	return out->ok;
+}
+
+static void emit_result(FILE* f, bool* first, const char* name, const char* mode, const BenchRun* r)
+{
+	uint64_t sum = 0;
+	for (unsigned int i = 0; i < r->count; ++i)
+		sum += r->samples[i];
+	const unsigned int n = r->count ? r->count : 1;
+
+	fprintf(f, "%s\n    {\"name\": \"%s\", \"mode\": \"%s\", \"ok\": %s, \"iters\": %u", *first ? "" : ",", name, mode,
+	        r->ok ? "true" : "false", r->count);
+	if (r->count)
+	{
+		fprintf(f, ", \"ns_min\": %llu, \"ns_median\": %llu, \"ns_p90\": %llu, \"ns_max\": %llu, \"ns_mean\": %llu",
+		        (unsigned long long)r->samples[0], (unsigned long long)r->samples[r->count / 2],
+		        (unsigned long long)r->samples[(r->count * 9U) / 10U], (unsigned long long)r->samples[r->count - 1],
+		        (unsigned long long)(sum / n));
+	}
+	fprintf(f,
+	        ", \"allocs_per_iter\": %.2f, \"alloc_bytes_per_iter\": %.1f, \"peak_heap_bytes\": %zu"
+	        ", \"opens_per_iter\": %.2f, \"read_bytes_per_iter\": %.1f}",
+	        (double)r->allocs / n, (double)r->alloc_bytes / n, r->peak_bytes, (double)r->opens / n,
+	        (double)r->read_bytes / n);
+	*first = false;
+}
+
+static bool bench_index(void* user)
+{
+	const char* index_name = (const char*)user;
+	NtxIndex idx;
+	char err[64];
+	if (!ntx_load_index(index_name, &idx, err, sizeof(err)))
+		return false;
+	ntx_free_index(&idx);
+	return true;
+}
+
+typedef struct
+{
+	const NtxIndex* idx;
+	const NtxNoteEntry* note;
+	uint32_t chunk;
+	char* buf;
+	uint16_t buf_size;
+} ChunkRef;
+
+static bool bench_chunk(void* user)
+{
+	const ChunkRef* ref = (const ChunkRef*)user;
+	char err[64];
+	const char* text = NULL;
+	uint16_t len = 0;
+	return ntx_load_chunk_text(ref->idx, ref->note, ref->chunk, ref->buf, ref->buf_size, &text, &len, NULL, err,
+	                           sizeof(err));
+}
+
+/* Maps a pack-wide chunk ordinal to its note and note-local chunk index,
+ * skipping whole shards by their chunk totals so only one shard is loaded. */
+static bool locate_chunk(NtxIndex* idx, uint32_t ordinal, ChunkRef* out)
+{
+	for (uint16_t s = 0; s < idx->shard_count; ++s)
+	{
+		const NtxShardInfo* shard = &idx->shards[s];
+		if (ordinal >= shard->total_chunks)
+		{
+			ordinal -= shard->total_chunks;
+			continue;
+		}
+		for (uint16_t n = shard->first_note; n < shard->first_note + shard->note_count; ++n)
+		{
+			const NtxNoteEntry* note = ntx_index_note(idx, n, NULL, 0);
+			if (!note)
+				return false;
+			if (ordinal < note->total_chunks)
+			{
+				out->idx = idx;
+				out->note = note;
+				out->chunk = ordinal;
+				return true;
+			}
+			ordinal -= note->total_chunks;
+		}
+		return false;
+	}
+	return false;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: ntxbench --vars DIR[:DIR...] [--index NAME] [--iters N] [--cold-iters N] [--label NAME]\n"
+	                "                [--out PATH]\n");
+}
+
+static bool parse_args(int argc, char** argv, BenchOptions* o)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* a = argv[i];
+		const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if (!v)
+			return false;
+		if (strcmp(a, "--vars") == 0)
+			o->vars = v;
+		else if (strcmp(a, "--index") == 0)
+			o->index_name = v;
+		else if (strcmp(a, "--out") == 0)
+			o->out_path = v;
+		else if (strcmp(a, "--label") == 0)
+			o->label = v;
+		else if (strcmp(a, "--iters") == 0)
+			o->iters = (unsigned int)strtoul(v, NULL, 10);
+		else if (strcmp(a, "--cold-iters") == 0)
+			o->cold_iters = (unsigned int)strtoul(v, NULL, 10);
+		else
+			return false;
+		i++;
+	}
+	return o->vars && o->iters > 0 && o->iters <= BENCH_MAX_ITERS && o->cold_iters > 0 &&
+	       o->cold_iters <= BENCH_MAX_ITERS;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions o = {
+		.vars = NULL,
+		.index_name = NTX_DEFAULT_INDEX,
+		.out_path = NULL,
+		.label = "pack",
+		.iters = 200,
+		.cold_iters = 20,
+	};
+	if (!parse_args(argc, argv, &o))
+	{
+		usage();
+		return 2;
+	}
+	host_fileioc_set_search_path(o.vars);
+
+	NtxIndex idx;
+	char err[64] = { 0 };
+	if (!ntx_load_index(o.index_name, &idx, err, sizeof(err)))
+	{
+		fprintf(stderr, "ntxbench: index load failed: %s\n", err);
+		return 1;
+	}
+
+	const uint32_t total_chunks = idx.total_chunks;
+	uint32_t total_parts = 0;
+	uint64_t total_text = 0;
+	for (uint16_t n = 0; n < idx.count; ++n)
+	{
+		const NtxNoteEntry* note = ntx_index_note(&idx, n, err, sizeof(err));
+		if (!note)
+		{
+			fprintf(stderr, "ntxbench: %s\n", err);
+			ntx_free_index(&idx);
+			return 1;
+		}
+		total_parts += note->part_count;
+		total_text += note->total_text_bytes;
+	}
+	if (total_chunks == 0)
+	{
+		fprintf(stderr, "ntxbench: pack has no chunks\n");
+		ntx_free_index(&idx);
+		return 1;
+	}
+
+	/* Allocated once outside the timed calls, like the viewer's text buffer. */
+	const uint16_t buf_size = (uint16_t)(idx.max_chunk_len + 1U);
+	char* buf = (char*)malloc(buf_size);
+	if (!buf)
+	{
+		fprintf(stderr, "ntxbench: oom chunk buffer\n");
+		ntx_free_index(&idx);
+		return 1;
+	}
+
+	FILE* f = o.out_path ? fopen(o.out_path, "w") : stdout;
+	if (!f)
+	{
+		fprintf(stderr, "ntxbench: cannot write %s\n", o.out_path);
+		free(buf);
+		ntx_free_index(&idx);
+		return 1;
+	}
+
+	fprintf(f,
+	        "{\n  \"label\": \"%s\",\n  \"notes\": %u,\n  \"shards\": %u,\n  \"parts\": %lu,\n  \"chunks\": %lu,\n"
+	        "  \"text_bytes\": %llu,\n  \"results\": [",
+	        o.label, (unsigned)idx.count, (unsigned)idx.shard_count, (unsigned long)total_parts,
+	        (unsigned long)total_chunks, (unsigned long long)total_text);
+
+	bool all_ok = true;
+	bool first = true;
+	BenchRun run;
+
+	all_ok &= run_bench(bench_index, (void*)o.index_name, o.cold_iters, true, &run);
+	emit_result(f, &first, "index_load", "cold", &run);
+	free(run.samples);
+	all_ok &= run_bench(bench_index, (void*)o.index_name, o.iters, false, &run);
+	emit_result(f, &first, "index_load", "warm", &run);
+	free(run.samples);
+
+	const struct
+	{
+		const char* name;
+		uint32_t ordinal;
+	} picks[] = {
+		{ "chunk_first", 0 },
+		{ "chunk_middle", total_chunks / 2U },
+		{ "chunk_last", total_chunks - 1U },
+	};
+	for (size_t i = 0; i < sizeof(picks) / sizeof(picks[0]); ++i)
+	{
+		ChunkRef ref;
+		ref.buf = buf;
+		ref.buf_size = buf_size;
+		if (!locate_chunk(&idx, picks[i].ordinal, &ref))
+		{
+			all_ok = false;
+			continue;
+		}
+		all_ok &= run_bench(bench_chunk, &ref, o.cold_iters, true, &run);
+		emit_result(f, &first, picks[i].name, "cold", &run);
+		free(run.samples);
+		all_ok &= run_bench(bench_chunk, &ref, o.iters, false, &run);
+		emit_result(f, &first, picks[i].name, "warm", &run);
+		free(run.samples);
+	}
+
+	fprintf(f, "\n  ]\n}\n");
+	if (f != stdout)
+		fclose(f);
+	free(buf);
+	ntx_free_index(&idx);
+	return all_ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Build ntxbench, pack the real notes/ corpus and a generated large library,
+run the reader benchmarks on both and write one JSON result file.
+
+    python3 bench/run_bench.py
+    python3 bench/run_bench.py --baseline old_results.json
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Run ntx pack reader benchmarks")
+    p.add_argument("--build-dir", type=Path, default=ROOT / "build/bench")
+    p.add_argument("--out", type=Path, help="results JSON (default: <build-dir>/results.json)")
+    p.add_argument("--baseline", type=Path, help="previous results JSON to diff against")
+    p.add_argument("--iters", type=int, default=200)
+    p.add_argument("--cold-iters", type=int, default=20)
+    p.add_argument("--large-notes", type=int, default=400, help="note count of the generated large pack")
+    return p.parse_args()
+
+
+def build_ntxbench(build_dir: Path) -> Path:
+    cmake_dir = build_dir / "cmake"
+    subprocess.run(["cmake", "-S", str(ROOT / "bench"), "-B", str(cmake_dir)], check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(["cmake", "--build", str(cmake_dir)], check=True, stdout=subprocess.DEVNULL)
+    return cmake_dir / "ntxbench"
+
+
+def generate_large_corpus(build_dir: Path, note_count: int) -> Path:
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/gen_corpus.py"),
+        "--out",
+        str(build_dir / "corpus"),
+        "--notes",
+        str(note_count),
+        "--mean-bytes",
+        "6000",
+    ]
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+    return build_dir / "corpus" / f"n{note_count}" / "notes"
+
+
+def build_pack(notes_dir: Path, pack_dir: Path) -> Path:
+    raw = pack_dir / "raw"
+    if pack_dir.exists():
+        shutil.rmtree(pack_dir)
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/build_pack.py"),
+        "--notes-dir",
+        str(notes_dir),
+        "--out-raw",
+        str(raw),
+        "--out-8xv",
+        str(pack_dir / "8xv"),
+        "--manifest",
+        str(pack_dir / "pack_manifest.json"),
+        "--skip-8xv",
+    ]
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return raw
+
+
+def run_ntxbench(binary: Path, raw: Path, label: str, args: argparse.Namespace) -> dict:
+    cmd = [
+        str(binary),
+        "--vars",
+        str(raw),
+        "--label",
+        label,
+        "--iters",
+        str(args.iters),
+        "--cold-iters",
+        str(args.cold_iters),
+    ]
+    proc = subprocess.run(cmd, check=True, capture_output=True, text=True)
+    return json.loads(proc.stdout)
+
+
+def print_diff(current: dict, baseline: dict) -> None:
+    def keyed(doc: dict) -> dict[tuple[str, str, str], dict]:
+        return {
+            (pack["label"], r["name"], r["mode"]): r for pack in doc["packs"] for r in pack["results"]
+        }
+
+    old = keyed(baseline)
+    print(f"{'pack':<8} {'bench':<14} {'mode':<5} {'median ns':>12} {'delta':>8} {'allocs':>7} {'bytes/iter':>11}")
+    for key, r in keyed(current).items():
+        base = old.get(key)
+        delta = ""
+        if base and base.get("ns_median"):
+            delta = f"{(r['ns_median'] - base['ns_median']) * 100.0 / base['ns_median']:+.1f}%"
+        print(
+            f"{key[0]:<8} {key[1]:<14} {key[2]:<5} {r.get('ns_median', 0):>12} {delta:>8} "
+            f"{r['allocs_per_iter']:>7.1f} {r['alloc_bytes_per_iter']:>11.1f}"
+        )
+
+
+def main() -> int:
+    args = parse_args()
+    build_dir: Path = args.build_dir.resolve()
+    build_dir.mkdir(parents=True, exist_ok=True)
+    out_path = (args.out or (build_dir / "results.json")).resolve()
+
+    binary = build_ntxbench(build_dir)
+
+    large_notes = generate_large_corpus(build_dir, args.large_notes)
+
+    packs = {
+        "notes": build_pack(ROOT / "notes", build_dir / "packs/notes"),
+        "large": build_pack(large_notes, build_dir / "packs/large"),
+    }
+    results = {"packs": [run_ntxbench(binary, raw, label, args) for label, raw in packs.items()]}
+    out_path.write_text(json.dumps(results, indent=2), encoding="utf-8")
+    print(f"Wrote {out_path}")
+
+    if args.baseline:
+        print_diff(results, json.loads(args.baseline.read_text(encoding="utf-8")))
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
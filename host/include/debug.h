@@ -0,0 +1,11 @@
+#ifndef HOST_DEBUG_H
+#define HOST_DEBUG_H
+
+/* Host stand-in for the CE debug header: dbg_printf goes to stderr. */
+
+#include <stdio.h>
+
+#define dbg_printf(...) fprintf(stderr, __VA_ARGS__)
+#define dbg_sprintf sprintf
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HOST_FILEIOC_H
+#define HOST_FILEIOC_H
+
+/* Host stand-in for the CE fileioc library. Variables are backed by files in a
+ * search path: NAME.bin holds raw AppVar data, NAME.8xv is unwrapped on open.
+ * Writes go to NAME.bin in the first search directory. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TI_PRGM_TYPE 0x05
+#define TI_PPRGM_TYPE 0x06
+#define TI_APPVAR_TYPE 0x15
+
+#define TI_MAX_SIZE 65505
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t ti_Open(const char* name, const char* mode);
+uint8_t ti_OpenVar(const char* varname, const char* mode, uint8_t type);
+int ti_Close(uint8_t handle);
+size_t ti_Write(const void* data, size_t size, size_t count, uint8_t handle);
+size_t ti_Read(void* data, size_t size, size_t count, uint8_t handle);
+int ti_GetC(uint8_t handle);
+int ti_PutC(char ch, uint8_t handle);
+int ti_Seek(int offset, unsigned int origin, uint8_t handle);
+int ti_Rewind(uint8_t handle);
+uint16_t ti_Tell(uint8_t handle);
+uint16_t ti_GetSize(uint8_t handle);
+int ti_Resize(size_t size, uint8_t handle);
+void* ti_GetDataPtr(uint8_t handle);
+int ti_Delete(const char* name);
+char* ti_Detect(void** curr_search_posistion, const char* detection_string);
+bool ti_SetArchiveStatus(bool archived, uint8_t handle);
+bool ti_IsArchived(uint8_t handle);
+
+/* Host-only: colon-separated directory list searched by ti_Open. Defaults to
+ * $NTX_HOST_VARS, then the current directory. */
+void host_fileioc_set_search_path(const char* dirs);
+
+/* Host-only: asks the kernel to drop cached pages of every variable file in
+ * the search path so the next ti_Open/ti_Read starts cold. */
+void host_fileioc_drop_cache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
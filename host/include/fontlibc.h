@@ -0,0 +1,86 @@
+#ifndef HOST_FONTLIBC_H
+#define HOST_FONTLIBC_H
+
+/* Host stand-in for the CE fontlibc library. Font packs are located through
+ * the fileioc stand-in and decoded from the same FONTPACK layout the
+ * calculator uses, so glyph metrics match the device exactly. */
+
+#include <host_types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+	uint8_t fontVersion;
+	uint8_t height;
+	uint8_t total_glyphs;
+	uint8_t first_glyph;
+	int24_t widths_table;
+	int24_t bitmaps;
+	int8_t italic_space_adjust;
+	uint8_t space_above;
+	uint8_t space_below;
+	uint8_t weight;
+	uint8_t style;
+	uint8_t cap_height;
+	uint8_t x_height;
+	uint8_t baseline_height;
+} fontlib_font_t;
+
+typedef enum
+{
+	FONTLIB_IGNORE_LINE_SPACING = 0x01
+} fontlib_load_options_t;
+
+typedef enum
+{
+	FONTLIB_ENABLE_AUTO_WRAP = 0x01,
+	FONTLIB_AUTO_CLEAR_TO_EOL = 0x02,
+	FONTLIB_PRECLEAR_NEWLINE = 0x04,
+	FONTLIB_AUTO_SCROLL = 0x08
+} fontlib_newline_options_t;
+
+fontlib_font_t* fontlib_GetFontByIndex(const char* font_pack_name, uint8_t index);
+fontlib_font_t* fontlib_GetFontByIndexRaw(const void* font_pack, uint8_t index);
+bool fontlib_SetFont(const fontlib_font_t* font_data, fontlib_load_options_t flags);
+
+void fontlib_SetWindowFullScreen(void);
+void fontlib_SetWindow(unsigned int x_min, uint8_t y_min, unsigned int width, uint8_t height);
+void fontlib_SetCursorPosition(unsigned int x, uint8_t y);
+unsigned int fontlib_GetCursorX(void);
+uint8_t fontlib_GetCursorY(void);
+void fontlib_ShiftCursorPosition(int x, int y);
+void fontlib_SetColors(uint8_t forecolor, uint8_t backcolor);
+void fontlib_SetForegroundColor(uint8_t forecolor);
+void fontlib_SetBackgroundColor(uint8_t backcolor);
+void fontlib_SetTransparency(bool transparency);
+bool fontlib_GetTransparency(void);
+void fontlib_SetLineSpacing(uint8_t space_above, uint8_t space_below);
+uint8_t fontlib_GetSpaceAbove(void);
+uint8_t fontlib_GetSpaceBelow(void);
+void fontlib_SetItalicSpacingAdjustment(uint8_t italic_spacing_adjustment);
+void fontlib_SetNewlineOptions(uint8_t options);
+void fontlib_SetFirstPrintableCodePoint(uint8_t code_point);
+void fontlib_SetAlternateStopCode(uint8_t code_point);
+
+uint8_t fontlib_GetCurrentFontHeight(void);
+uint8_t fontlib_GetTotalGlyphs(void);
+uint8_t fontlib_GetFirstGlyph(void);
+bool fontlib_ValidateCodePoint(char code_point);
+uint8_t fontlib_GetGlyphWidth(char code_point);
+unsigned int fontlib_GetStringWidth(const char* str);
+unsigned int fontlib_GetStringWidthL(const char* str, unsigned int max_characters);
+
+unsigned int fontlib_DrawGlyph(uint8_t glyph);
+unsigned int fontlib_DrawString(const char* str);
+unsigned int fontlib_DrawStringL(const char* str, unsigned int max_characters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
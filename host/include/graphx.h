@@ -0,0 +1,95 @@
+#ifndef HOST_GRAPHX_H
+#define HOST_GRAPHX_H
+
+/* Host stand-in for the CE graphx library, drawing into an in-memory 8bpp
+ * framebuffer pair. Only the subset used by the viewer and libtexce exists. */
+
+#include <host_types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GFX_LCD_WIDTH 320
+#define GFX_LCD_HEIGHT 240
+
+#define gfx_screen 0
+#define gfx_buffer 1
+
+#define gfx_RGBTo1555(r, g, b) \
+	((uint16_t)(((uint8_t)(r) >> 3) << 10) | (((uint8_t)(g) >> 3) << 5) | ((uint8_t)(b) >> 3))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+	uint8_t width;
+	uint8_t height;
+	uint8_t data[];
+} gfx_sprite_t;
+
+extern uint16_t gfx_palette[256];
+
+void gfx_Begin(void);
+void gfx_End(void);
+void gfx_SetDraw(uint8_t location);
+void gfx_SwapDraw(void);
+void gfx_Wait(void);
+void gfx_Blit(uint8_t src);
+
+#define gfx_SetDrawBuffer() gfx_SetDraw(gfx_buffer)
+#define gfx_SetDrawScreen() gfx_SetDraw(gfx_screen)
+#define gfx_BlitBuffer() gfx_Blit(gfx_buffer)
+
+uint8_t gfx_SetColor(uint8_t index);
+uint8_t gfx_SetTransparentColor(uint8_t index);
+void gfx_FillScreen(uint8_t index);
+void gfx_ZeroScreen(void);
+void gfx_SetClipRegion(int xmin, int ymin, int xmax, int ymax);
+
+void gfx_SetPixel(uint24_t x, uint8_t y);
+uint8_t gfx_GetPixel(uint24_t x, uint8_t y);
+void gfx_Line(int x0, int y0, int x1, int y1);
+void gfx_Line_NoClip(uint24_t x0, uint8_t y0, uint24_t x1, uint8_t y1);
+void gfx_HorizLine(int x, int y, int length);
+void gfx_HorizLine_NoClip(uint24_t x, uint8_t y, uint24_t length);
+void gfx_VertLine(int x, int y, int length);
+void gfx_VertLine_NoClip(uint24_t x, uint8_t y, uint24_t length);
+void gfx_Rectangle(int x, int y, int width, int height);
+void gfx_Rectangle_NoClip(uint24_t x, uint8_t y, uint24_t width, uint8_t height);
+void gfx_FillRectangle(int x, int y, int width, int height);
+void gfx_FillRectangle_NoClip(uint24_t x, uint8_t y, uint24_t width, uint8_t height);
+void gfx_Circle(int x, int y, uint24_t radius);
+void gfx_FillCircle(int x, int y, uint24_t radius);
+
+void gfx_Sprite(const gfx_sprite_t* sprite, int x, int y);
+void gfx_Sprite_NoClip(const gfx_sprite_t* sprite, uint24_t x, uint8_t y);
+void gfx_TransparentSprite(const gfx_sprite_t* sprite, int x, int y);
+void gfx_TransparentSprite_NoClip(const gfx_sprite_t* sprite, uint24_t x, uint8_t y);
+gfx_sprite_t* gfx_GetSprite(gfx_sprite_t* sprite_buffer, int x, int y);
+
+uint8_t gfx_SetTextFGColor(uint8_t color);
+uint8_t gfx_SetTextBGColor(uint8_t color);
+uint8_t gfx_SetTextTransparentColor(uint8_t color);
+void gfx_SetTextXY(int x, int y);
+int gfx_GetTextX(void);
+int gfx_GetTextY(void);
+void gfx_PrintChar(const char c);
+void gfx_PrintString(const char* string);
+void gfx_PrintStringXY(const char* string, int x, int y);
+void gfx_PrintInt(int n, uint8_t length);
+void gfx_PrintUInt(unsigned int n, uint8_t length);
+unsigned int gfx_GetStringWidth(const char* string);
+unsigned int gfx_GetCharWidth(const char c);
+
+/* Host-only: when a directory is set, each gfx_SwapDraw that changes the
+ * visible frame writes DIR/frame_NNNNN.ppm. */
+void host_gfx_set_frame_dir(const char* dir);
+bool host_gfx_write_ppm(const char* path);
+unsigned int host_gfx_frames_written(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
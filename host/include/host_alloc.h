@@ -0,0 +1,30 @@
+#ifndef HOST_ALLOC_H
+#define HOST_ALLOC_H
+
+/* Heap accounting for host builds. Executables link with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free so every
+ * allocation made by the viewer, the pack reader and libtexce is counted. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+	size_t live_bytes;
+	size_t peak_bytes;
+	uint64_t alloc_count;
+	uint64_t alloc_bytes;
+	uint64_t free_count;
+} HostAllocStats;
+
+HostAllocStats host_alloc_stats(void);
+
+/* Restarts peak tracking and the alloc/free counters from the current live size. */
+void host_alloc_reset_peak(void);
+
+/* While armed, remembers the first allocation of at least min_size bytes.
+ * host_alloc_watched() returns it and disarms the watch. */
+void host_alloc_watch(size_t min_size);
+void* host_alloc_watched(size_t* out_size);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef HOST_STATS_H
+#define HOST_STATS_H
+
+/* Per-operation counters maintained by the host stand-in libraries. */
+
+#include <stdint.h>
+#include <time.h>
+
+typedef enum
+{
+	HOST_OP_GFX_FILL,
+	HOST_OP_GFX_LINE,
+	HOST_OP_GFX_PIXEL,
+	HOST_OP_GFX_TEXT,
+	HOST_OP_GFX_SPRITE,
+	HOST_OP_GFX_SWAP,
+	HOST_OP_FONT_GLYPH,
+	HOST_OP_TI_OPEN,
+	HOST_OP_TI_READ,
+	HOST_OP_KB_SCAN,
+	HOST_OP_NTX_INDEX,
+	HOST_OP_NTX_CHUNK,
+	HOST_OP_TEX_FORMAT,
+	HOST_OP_TEX_DRAW,
+	HOST_OP_COUNT
+} HostOp;
+
+typedef struct
+{
+	uint64_t calls;
+	uint64_t pixels;
+	uint64_t ns;
+} HostOpStat;
+
+extern HostOpStat host_op_stats[HOST_OP_COUNT];
+
+void host_stats_reset(void);
+const char* host_op_name(HostOp op);
+
+static inline uint64_t host_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static inline void host_stats_count(HostOp op, uint64_t pixels)
+{
+	host_op_stats[op].calls++;
+	host_op_stats[op].pixels += pixels;
+}
+
+/* Counts one call of op that started at t0 (from host_now_ns). */
+static inline void host_stats_timed(HostOp op, uint64_t t0, uint64_t pixels)
+{
+	host_op_stats[op].ns += host_now_ns() - t0;
+	host_stats_count(op, pixels);
+}
+
+#endif
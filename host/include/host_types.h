@@ -0,0 +1,14 @@
+#ifndef HOST_TYPES_H
+#define HOST_TYPES_H
+
+/* eZ80 24-bit integer types used throughout the CE toolchain headers. */
+
+#include <stdint.h>
+
+#ifndef HOST_HAVE_INT24
+#define HOST_HAVE_INT24
+typedef int32_t int24_t;
+typedef uint32_t uint24_t;
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef HOST_KEYPADC_H
+#define HOST_KEYPADC_H
+
+/* Host stand-in for the CE keypadc library. kb_Scan() replays a key script
+ * (see host/src/keypadc.c) instead of reading the keypad matrix. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint8_t kb_Data[8];
+
+void kb_Scan(void);
+void kb_Reset(void);
+uint8_t kb_AnyKey(void);
+
+/* Group 1 */
+#define kb_Graph (1 << 0)
+#define kb_Trace (1 << 1)
+#define kb_Zoom (1 << 2)
+#define kb_Window (1 << 3)
+#define kb_Yequ (1 << 4)
+#define kb_2nd (1 << 5)
+#define kb_Mode (1 << 6)
+#define kb_Del (1 << 7)
+
+/* Group 2 */
+#define kb_Store (1 << 1)
+#define kb_Ln (1 << 2)
+#define kb_Log (1 << 3)
+#define kb_Square (1 << 4)
+#define kb_Recip (1 << 5)
+#define kb_Math (1 << 6)
+#define kb_Alpha (1 << 7)
+
+/* Group 3 */
+#define kb_0 (1 << 0)
+#define kb_1 (1 << 1)
+#define kb_4 (1 << 2)
+#define kb_7 (1 << 3)
+
+/* Group 4 */
+#define kb_DecPnt (1 << 0)
+#define kb_2 (1 << 1)
+#define kb_5 (1 << 2)
+#define kb_8 (1 << 3)
+
+/* Group 5 */
+#define kb_Chs (1 << 0)
+#define kb_3 (1 << 1)
+#define kb_6 (1 << 2)
+#define kb_9 (1 << 3)
+
+/* Group 6 */
+#define kb_Enter (1 << 0)
+#define kb_Add (1 << 1)
+#define kb_Sub (1 << 2)
+#define kb_Mul (1 << 3)
+#define kb_Div (1 << 4)
+#define kb_Power (1 << 5)
+#define kb_Clear (1 << 6)
+
+/* Group 7 */
+#define kb_Down (1 << 0)
+#define kb_Left (1 << 1)
+#define kb_Right (1 << 2)
+#define kb_Up (1 << 3)
+
+/* Host-only: loads a key script; NULL falls back to $NTX_HOST_KEYS. */
+bool host_keypad_load_script(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef HOST_SYS_TIMERS_H
+#define HOST_SYS_TIMERS_H
+
+/* Host stand-in for the CE hardware timers, derived from the host monotonic
+ * clock: TIMER_CPU counts at the calculator's 48 MHz, TIMER_32K at 32768 Hz.
+ * Timer state is per translation unit, which is enough for the viewer's
+ * single-file users. */
+
+#include <host_stats.h>
+#include <stdint.h>
+
+#define TIMER_CPU 0
+#define TIMER_32K 1
+#define TIMER_NOINT 0
+#define TIMER_0INT 1
+#define TIMER_UP 1
+#define TIMER_DOWN 0
+
+static uint8_t host_timer_rate[4];
+
+static inline void host_timer_enable(int n, int rate)
+{
+	host_timer_rate[n & 3] = (uint8_t)rate;
+}
+
+static inline uint32_t host_timer_get(int n)
+{
+	const uint64_t ns = host_now_ns();
+	if (host_timer_rate[n & 3] == TIMER_32K)
+		return (uint32_t)((ns * 32768U) / 1000000000U);
+	return (uint32_t)((ns * 48U) / 1000U);
+}
+
+#define timer_Enable(n, rate, inter, dir) ((void)(inter), (void)(dir), host_timer_enable((n), (rate)))
+#define timer_Disable(n) ((void)(n))
+#define timer_Set(n, value) ((void)(n), (void)(value))
+#define timer_Get(n) host_timer_get(n)
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef HOST_TICE_H
+#define HOST_TICE_H
+
+/* Host stand-in for the CE tice header; only what the viewer touches. */
+
+#include <host_types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void delay(uint16_t msec);
+void boot_NewLine(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,511 @@
+#include <fileioc.h>
+#include <host_stats.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HOST_MAX_HANDLES 5
+#define HOST_VAR_CAPACITY 65535U
+#define HOST_8X_DATA_OFFSET 74U
+
+typedef struct
+{
+	bool used;
+	bool writable;
+	bool archived;
+	char name[9];
+	char path[1280];
+	uint8_t* map;
+	size_t map_len;
+	uint8_t* data;
+	uint16_t size;
+	uint16_t offset;
+} HostVar;
+
+static HostVar s_vars[HOST_MAX_HANDLES];
+static char s_search_path[4096];
+static bool s_search_path_set = false;
+static char s_detect_name[9];
+
+void host_fileioc_set_search_path(const char* dirs)
+{
+	snprintf(s_search_path, sizeof(s_search_path), "%s", (dirs && dirs[0]) ? dirs : ".");
+	s_search_path_set = true;
+}
+
+static const char* search_path(void)
+{
+	if (!s_search_path_set)
+		host_fileioc_set_search_path(getenv("NTX_HOST_VARS"));
+	return s_search_path;
+}
+
+/* Calls fn(dir) for each search directory until it returns true. */
+static bool for_each_dir(bool (*fn)(const char* dir, void* user), void* user)
+{
+	const char* p = search_path();
+	char dir[1024];
+	while (*p)
+	{
+		const char* end = strchr(p, ':');
+		size_t n = end ? (size_t)(end - p) : strlen(p);
+		if (n >= sizeof(dir))
+			n = sizeof(dir) - 1;
+		memcpy(dir, p, n);
+		dir[n] = '\0';
+		if (n > 0 && fn(dir, user))
+			return true;
+		if (!end)
+			break;
+		p = end + 1;
+	}
+	return false;
+}
+
+static void first_dir(char* out, size_t out_len)
+{
+	const char* p = search_path();
+	const char* end = strchr(p, ':');
+	size_t n = end ? (size_t)(end - p) : strlen(p);
+	if (n == 0)
+	{
+		snprintf(out, out_len, ".");
+		return;
+	}
+	if (n >= out_len)
+		n = out_len - 1;
+	memcpy(out, p, n);
+	out[n] = '\0';
+}
+
+typedef struct
+{
+	const char* name;
+	HostVar* var;
+} FindCtx;
+
+static bool map_file(const char* path, uint8_t** out_map, size_t* out_len)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	*out_map = (uint8_t*)map;
+	*out_len = (size_t)st.st_size;
+	return true;
+}
+
+/* Locates the AppVar payload inside a single-variable .8xv file. */
+static bool unwrap_8xv(const uint8_t* file, size_t len, const uint8_t** out_data, uint16_t* out_size)
+{
+	if (len < HOST_8X_DATA_OFFSET || memcmp(file, "**TI83F*", 8) != 0)
+		return false;
+	uint16_t size = (uint16_t)(file[HOST_8X_DATA_OFFSET - 2] | (file[HOST_8X_DATA_OFFSET - 1] << 8));
+	if ((size_t)HOST_8X_DATA_OFFSET + size > len)
+		return false;
+	*out_data = file + HOST_8X_DATA_OFFSET;
+	*out_size = size;
+	return true;
+}
+
+static bool find_in_dir(const char* dir, void* user)
+{
+	FindCtx* ctx = (FindCtx*)user;
+	HostVar* v = ctx->var;
+	uint8_t* map = NULL;
+	size_t map_len = 0;
+
+	snprintf(v->path, sizeof(v->path), "%s/%s.bin", dir, ctx->name);
+	if (map_file(v->path, &map, &map_len))
+	{
+		if (map_len > HOST_VAR_CAPACITY)
+		{
+			munmap(map, map_len);
+			return false;
+		}
+		v->map = map;
+		v->map_len = map_len;
+		v->data = map;
+		v->size = (uint16_t)map_len;
+		return true;
+	}
+
+	snprintf(v->path, sizeof(v->path), "%s/%s.8xv", dir, ctx->name);
+	if (map_file(v->path, &map, &map_len))
+	{
+		const uint8_t* data = NULL;
+		uint16_t size = 0;
+		if (!unwrap_8xv(map, map_len, &data, &size))
+		{
+			munmap(map, map_len);
+			return false;
+		}
+		v->map = map;
+		v->map_len = map_len;
+		v->data = (uint8_t*)data;
+		v->size = size;
+		v->archived = true;
+		return true;
+	}
+	return false;
+}
+
+static HostVar* get_var(uint8_t handle)
+{
+	if (handle == 0 || handle > HOST_MAX_HANDLES || !s_vars[handle - 1].used)
+		return NULL;
+	return &s_vars[handle - 1];
+}
+
+/* Writable variables live in an anonymous mapping so they never show up in
+ * host heap accounting. */
+static bool make_writable(HostVar* v)
+{
+	void* buf = mmap(NULL, HOST_VAR_CAPACITY, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		return false;
+	if (v->data && v->size)
+		memcpy(buf, v->data, v->size);
+	if (v->map)
+		munmap(v->map, v->map_len);
+	v->map = (uint8_t*)buf;
+	v->map_len = HOST_VAR_CAPACITY;
+	v->data = (uint8_t*)buf;
+	v->writable = true;
+	return true;
+}
+
+uint8_t ti_Open(const char* name, const char* mode)
+{
+	const uint64_t t0 = host_now_ns();
+	if (!name || !mode || !name[0] || strlen(name) > 8)
+		return 0;
+
+	uint8_t slot = 0;
+	for (uint8_t i = 0; i < HOST_MAX_HANDLES; ++i)
+	{
+		if (!s_vars[i].used)
+		{
+			slot = (uint8_t)(i + 1);
+			break;
+		}
+	}
+	if (!slot)
+		return 0;
+
+	HostVar* v = &s_vars[slot - 1];
+	memset(v, 0, sizeof(*v));
+	snprintf(v->name, sizeof(v->name), "%s", name);
+
+	FindCtx ctx = { name, v };
+	bool found = for_each_dir(find_in_dir, &ctx);
+	bool want_write = (mode[0] == 'w' || mode[0] == 'a' || strchr(mode, '+') != NULL);
+
+	if (!found)
+	{
+		if (mode[0] == 'r')
+			return 0;
+		char dir[1024];
+		first_dir(dir, sizeof(dir));
+		snprintf(v->path, sizeof(v->path), "%s/%s.bin", dir, name);
+	}
+	else if (want_write && strstr(v->path, ".8xv"))
+	{
+		char dir[1024];
+		first_dir(dir, sizeof(dir));
+		snprintf(v->path, sizeof(v->path), "%s/%s.bin", dir, name);
+	}
+
+	if (want_write)
+	{
+		if (mode[0] == 'w')
+			v->size = 0;
+		if (!make_writable(v))
+		{
+			if (v->map)
+				munmap(v->map, v->map_len);
+			return 0;
+		}
+		if (mode[0] == 'a')
+			v->offset = v->size;
+	}
+
+	v->used = true;
+	host_stats_timed(HOST_OP_TI_OPEN, t0, 0);
+	return slot;
+}
+
+uint8_t ti_OpenVar(const char* varname, const char* mode, uint8_t type)
+{
+	(void)type;
+	return ti_Open(varname, mode);
+}
+
+int ti_Close(uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	if (!v)
+		return 0;
+
+	int ok = 1;
+	if (v->writable)
+	{
+		FILE* f = fopen(v->path, "wb");
+		if (!f || fwrite(v->data, 1, v->size, f) != v->size)
+			ok = 0;
+		if (f)
+			fclose(f);
+	}
+	if (v->map)
+		munmap(v->map, v->map_len);
+	memset(v, 0, sizeof(*v));
+	return ok;
+}
+
+size_t ti_Write(const void* data, size_t size, size_t count, uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	if (!v || !v->writable || !data || size == 0)
+		return 0;
+
+	size_t done = 0;
+	while (done < count)
+	{
+		if ((size_t)v->offset + size > HOST_VAR_CAPACITY)
+			break;
+		memcpy(v->data + v->offset, (const uint8_t*)data + (done * size), size);
+		v->offset = (uint16_t)(v->offset + size);
+		if (v->offset > v->size)
+			v->size = v->offset;
+		done++;
+	}
+	return done;
+}
+
+size_t ti_Read(void* data, size_t size, size_t count, uint8_t handle)
+{
+	const uint64_t t0 = host_now_ns();
+	HostVar* v = get_var(handle);
+	if (!v || !data || size == 0)
+		return 0;
+
+	size_t done = 0;
+	while (done < count)
+	{
+		if ((size_t)v->offset + size > v->size)
+			break;
+		memcpy((uint8_t*)data + (done * size), v->data + v->offset, size);
+		v->offset = (uint16_t)(v->offset + size);
+		done++;
+	}
+	host_stats_timed(HOST_OP_TI_READ, t0, done * size);
+	return done;
+}
+
+int ti_GetC(uint8_t handle)
+{
+	uint8_t c = 0;
+	return (ti_Read(&c, 1, 1, handle) == 1) ? (int)c : EOF;
+}
+
+int ti_PutC(char ch, uint8_t handle)
+{
+	return (ti_Write(&ch, 1, 1, handle) == 1) ? (int)(uint8_t)ch : EOF;
+}
+
+int ti_Seek(int offset, unsigned int origin, uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	if (!v)
+		return EOF;
+
+	long base = 0;
+	if (origin == SEEK_CUR)
+		base = v->offset;
+	else if (origin == SEEK_END)
+		base = v->size;
+	long pos = base + offset;
+	if (pos < 0 || pos > v->size)
+		return EOF;
+	v->offset = (uint16_t)pos;
+	return 0;
+}
+
+int ti_Rewind(uint8_t handle)
+{
+	return ti_Seek(0, SEEK_SET, handle);
+}
+
+uint16_t ti_Tell(uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	return v ? v->offset : 0;
+}
+
+uint16_t ti_GetSize(uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	return v ? v->size : 0;
+}
+
+int ti_Resize(size_t size, uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	if (!v || !v->writable || size > HOST_VAR_CAPACITY)
+		return -1;
+	if (size > v->size)
+		memset(v->data + v->size, 0, size - v->size);
+	v->size = (uint16_t)size;
+	if (v->offset > v->size)
+		v->offset = v->size;
+	return (int)size;
+}
+
+void* ti_GetDataPtr(uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	return v ? (void*)(v->data + v->offset) : NULL;
+}
+
+int ti_Delete(const char* name)
+{
+	if (!name)
+		return 0;
+	char dir[1024];
+	char path[1100];
+	first_dir(dir, sizeof(dir));
+	snprintf(path, sizeof(path), "%s/%s.bin", dir, name);
+	return unlink(path) == 0;
+}
+
+typedef struct
+{
+	const char* detect;
+	size_t detect_len;
+	uintptr_t skip;
+	uintptr_t seen;
+	bool found;
+} DetectCtx;
+
+static int compare_names(const struct dirent** a, const struct dirent** b)
+{
+	return strcmp((*a)->d_name, (*b)->d_name);
+}
+
+static bool detect_in_dir(const char* dir, void* user)
+{
+	DetectCtx* ctx = (DetectCtx*)user;
+	struct dirent** list = NULL;
+	int n = scandir(dir, &list, NULL, compare_names);
+	if (n < 0)
+		return false;
+
+	for (int i = 0; i < n; ++i)
+	{
+		if (ctx->found)
+		{
+			free(list[i]);
+			continue;
+		}
+		const char* fname = list[i]->d_name;
+		const char* dot = strrchr(fname, '.');
+		size_t stem = dot ? (size_t)(dot - fname) : 0;
+		if (!dot || stem == 0 || stem > 8 || (strcmp(dot, ".bin") != 0 && strcmp(dot, ".8xv") != 0))
+		{
+			free(list[i]);
+			continue;
+		}
+
+		char name[9];
+		memcpy(name, fname, stem);
+		name[stem] = '\0';
+		uint8_t h = ti_Open(name, "r");
+		if (h)
+		{
+			HostVar* v = get_var(h);
+			bool match = v->size >= ctx->detect_len && memcmp(v->data, ctx->detect, ctx->detect_len) == 0;
+			ti_Close(h);
+			if (match && ++ctx->seen > ctx->skip)
+			{
+				snprintf(s_detect_name, sizeof(s_detect_name), "%s", name);
+				ctx->found = true;
+			}
+		}
+		free(list[i]);
+	}
+	free(list);
+	return ctx->found;
+}
+
+char* ti_Detect(void** curr_search_posistion, const char* detection_string)
+{
+	if (!curr_search_posistion)
+		return NULL;
+
+	DetectCtx ctx = { 0 };
+	ctx.detect = detection_string ? detection_string : "";
+	ctx.detect_len = strlen(ctx.detect);
+	ctx.skip = (uintptr_t)*curr_search_posistion;
+	if (!for_each_dir(detect_in_dir, &ctx))
+		return NULL;
+	*curr_search_posistion = (void*)(ctx.skip + 1);
+	return s_detect_name;
+}
+
+static bool drop_dir(const char* dir, void* user)
+{
+	(void)user;
+	DIR* d = opendir(dir);
+	if (!d)
+		return false;
+	struct dirent* e;
+	while ((e = readdir(d)) != NULL)
+	{
+		const char* dot = strrchr(e->d_name, '.');
+		if (!dot || (strcmp(dot, ".bin") != 0 && strcmp(dot, ".8xv") != 0))
+			continue;
+		char path[1280];
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			continue;
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+	closedir(d);
+	return false;
+}
+
+void host_fileioc_drop_cache(void)
+{
+	for_each_dir(drop_dir, NULL);
+}
+
+bool ti_SetArchiveStatus(bool archived, uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	if (!v)
+		return false;
+	v->archived = archived;
+	return true;
+}
+
+bool ti_IsArchived(uint8_t handle)
+{
+	HostVar* v = get_var(handle);
+	return v ? v->archived : false;
+}
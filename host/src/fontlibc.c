@@ -0,0 +1,406 @@
+#include "host_gfx.h"
+
+#include <fileioc.h>
+#include <fontlibc.h>
+#include <host_stats.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define HOST_MAX_FONTS 8
+#define FONTPACK_MAGIC "FONTPACK"
+#define FONT_HEADER_SIZE 18U
+
+typedef struct
+{
+	fontlib_font_t font;
+	const uint8_t* base;
+	const uint8_t* pack;
+	uint8_t index;
+	char pack_name[9];
+} HostFont;
+
+typedef struct
+{
+	char name[9];
+	uint8_t* data;
+	size_t size;
+} HostFontPack;
+
+static HostFont s_fonts[HOST_MAX_FONTS];
+static uint8_t s_font_count = 0;
+static HostFontPack s_packs[HOST_MAX_FONTS];
+static uint8_t s_pack_count = 0;
+
+static const HostFont* s_cur = NULL;
+static int s_win_x = 0;
+static int s_win_y = 0;
+static int s_win_w = GFX_LCD_WIDTH;
+static int s_win_h = GFX_LCD_HEIGHT;
+static int s_cursor_x = 0;
+static int s_cursor_y = 0;
+static uint8_t s_fg = 0;
+static uint8_t s_bg = 255;
+static bool s_transparent = false;
+static uint8_t s_space_above = 0;
+static uint8_t s_space_below = 0;
+static uint8_t s_first_printable = 0x10;
+static uint8_t s_alt_stop = 0;
+
+static uint32_t read_u24(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static int32_t read_s24(const uint8_t* p)
+{
+	uint32_t v = read_u24(p);
+	return (v & 0x800000U) ? (int32_t)(v | 0xFF000000U) : (int32_t)v;
+}
+
+/* Copies a font pack out of its variable into a private mapping, mirroring
+ * the calculator where archived font data stays addressable after ti_Close. */
+static const uint8_t* load_pack(const char* name, size_t* out_size)
+{
+	for (uint8_t i = 0; i < s_pack_count; ++i)
+	{
+		if (strcmp(s_packs[i].name, name) == 0)
+		{
+			*out_size = s_packs[i].size;
+			return s_packs[i].data;
+		}
+	}
+	if (s_pack_count >= HOST_MAX_FONTS)
+		return NULL;
+
+	uint8_t h = ti_Open(name, "r");
+	if (!h)
+		return NULL;
+	size_t size = ti_GetSize(h);
+	const void* src = ti_GetDataPtr(h);
+	void* copy = (size > 0) ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+	if (copy == MAP_FAILED)
+	{
+		ti_Close(h);
+		return NULL;
+	}
+	memcpy(copy, src, size);
+	ti_Close(h);
+
+	HostFontPack* pack = &s_packs[s_pack_count++];
+	snprintf(pack->name, sizeof(pack->name), "%s", name);
+	pack->data = (uint8_t*)copy;
+	pack->size = size;
+	*out_size = size;
+	return pack->data;
+}
+
+static fontlib_font_t* decode_font(const uint8_t* pack, size_t pack_size, uint8_t index, const char* pack_name)
+{
+	for (uint8_t i = 0; i < s_font_count; ++i)
+	{
+		if (s_fonts[i].pack == pack && s_fonts[i].index == index)
+			return &s_fonts[i].font;
+	}
+	if (s_font_count >= HOST_MAX_FONTS || pack_size < 12 || memcmp(pack, FONTPACK_MAGIC, 8) != 0)
+		return NULL;
+
+	uint8_t count = pack[11];
+	if (index >= count || pack_size < 12U + ((size_t)count * 3U))
+		return NULL;
+	uint32_t off = read_u24(pack + 12 + ((size_t)index * 3U));
+	if ((size_t)off + FONT_HEADER_SIZE > pack_size)
+		return NULL;
+
+	const uint8_t* f = pack + off;
+	HostFont* hf = &s_fonts[s_font_count++];
+	memset(hf, 0, sizeof(*hf));
+	hf->base = f;
+	hf->pack = pack;
+	hf->index = index;
+	snprintf(hf->pack_name, sizeof(hf->pack_name), "%s", pack_name ? pack_name : "");
+	hf->font.fontVersion = f[0];
+	hf->font.height = f[1];
+	hf->font.total_glyphs = f[2];
+	hf->font.first_glyph = f[3];
+	hf->font.widths_table = read_s24(f + 4);
+	hf->font.bitmaps = read_s24(f + 7);
+	hf->font.italic_space_adjust = (int8_t)f[10];
+	hf->font.space_above = f[11];
+	hf->font.space_below = f[12];
+	hf->font.weight = f[13];
+	hf->font.style = f[14];
+	hf->font.cap_height = f[15];
+	hf->font.x_height = f[16];
+	hf->font.baseline_height = f[17];
+	return &hf->font;
+}
+
+fontlib_font_t* fontlib_GetFontByIndex(const char* font_pack_name, uint8_t index)
+{
+	if (!font_pack_name)
+		return NULL;
+	size_t size = 0;
+	const uint8_t* pack = load_pack(font_pack_name, &size);
+	return pack ? decode_font(pack, size, index, font_pack_name) : NULL;
+}
+
+fontlib_font_t* fontlib_GetFontByIndexRaw(const void* font_pack, uint8_t index)
+{
+	if (!font_pack)
+		return NULL;
+	/* Raw packs carry no size; trust the header like the calculator does. */
+	return decode_font((const uint8_t*)font_pack, 0xFFFFU, index, NULL);
+}
+
+static const HostFont* host_font(const fontlib_font_t* font)
+{
+	for (uint8_t i = 0; i < s_font_count; ++i)
+	{
+		if (&s_fonts[i].font == font)
+			return &s_fonts[i];
+	}
+	return NULL;
+}
+
+bool fontlib_SetFont(const fontlib_font_t* font_data, fontlib_load_options_t flags)
+{
+	const HostFont* hf = host_font(font_data);
+	if (!hf)
+		return false;
+	s_cur = hf;
+	if (!(flags & FONTLIB_IGNORE_LINE_SPACING))
+	{
+		s_space_above = hf->font.space_above;
+		s_space_below = hf->font.space_below;
+	}
+	return true;
+}
+
+void fontlib_SetWindowFullScreen(void)
+{
+	fontlib_SetWindow(0, 0, GFX_LCD_WIDTH, GFX_LCD_HEIGHT);
+}
+
+void fontlib_SetWindow(unsigned int x_min, uint8_t y_min, unsigned int width, uint8_t height)
+{
+	s_win_x = (int)x_min;
+	s_win_y = (int)y_min;
+	s_win_w = (int)width;
+	s_win_h = (int)height;
+}
+
+void fontlib_SetCursorPosition(unsigned int x, uint8_t y)
+{
+	s_cursor_x = (int)x;
+	s_cursor_y = (int)y;
+}
+
+unsigned int fontlib_GetCursorX(void)
+{
+	return (unsigned int)s_cursor_x;
+}
+
+uint8_t fontlib_GetCursorY(void)
+{
+	return (uint8_t)s_cursor_y;
+}
+
+void fontlib_ShiftCursorPosition(int x, int y)
+{
+	s_cursor_x += x;
+	s_cursor_y += y;
+}
+
+void fontlib_SetColors(uint8_t forecolor, uint8_t backcolor)
+{
+	s_fg = forecolor;
+	s_bg = backcolor;
+}
+
+void fontlib_SetForegroundColor(uint8_t forecolor)
+{
+	s_fg = forecolor;
+}
+
+void fontlib_SetBackgroundColor(uint8_t backcolor)
+{
+	s_bg = backcolor;
+}
+
+void fontlib_SetTransparency(bool transparency)
+{
+	s_transparent = transparency;
+}
+
+bool fontlib_GetTransparency(void)
+{
+	return s_transparent;
+}
+
+void fontlib_SetLineSpacing(uint8_t space_above, uint8_t space_below)
+{
+	s_space_above = space_above;
+	s_space_below = space_below;
+}
+
+uint8_t fontlib_GetSpaceAbove(void)
+{
+	return s_space_above;
+}
+
+uint8_t fontlib_GetSpaceBelow(void)
+{
+	return s_space_below;
+}
+
+void fontlib_SetItalicSpacingAdjustment(uint8_t italic_spacing_adjustment)
+{
+	(void)italic_spacing_adjustment;
+}
+
+void fontlib_SetNewlineOptions(uint8_t options)
+{
+	(void)options;
+}
+
+void fontlib_SetFirstPrintableCodePoint(uint8_t code_point)
+{
+	s_first_printable = code_point;
+}
+
+void fontlib_SetAlternateStopCode(uint8_t code_point)
+{
+	s_alt_stop = code_point;
+}
+
+uint8_t fontlib_GetCurrentFontHeight(void)
+{
+	return s_cur ? s_cur->font.height : 0;
+}
+
+uint8_t fontlib_GetTotalGlyphs(void)
+{
+	return s_cur ? s_cur->font.total_glyphs : 0;
+}
+
+uint8_t fontlib_GetFirstGlyph(void)
+{
+	return s_cur ? s_cur->font.first_glyph : 0;
+}
+
+static bool glyph_index(uint8_t code_point, unsigned int* out_index)
+{
+	if (!s_cur)
+		return false;
+	unsigned int total = s_cur->font.total_glyphs ? s_cur->font.total_glyphs : 256U;
+	if (code_point < s_cur->font.first_glyph)
+		return false;
+	unsigned int idx = (unsigned int)(code_point - s_cur->font.first_glyph);
+	if (idx >= total)
+		return false;
+	*out_index = idx;
+	return true;
+}
+
+bool fontlib_ValidateCodePoint(char code_point)
+{
+	unsigned int idx = 0;
+	return glyph_index((uint8_t)code_point, &idx);
+}
+
+uint8_t fontlib_GetGlyphWidth(char code_point)
+{
+	unsigned int idx = 0;
+	if (!glyph_index((uint8_t)code_point, &idx))
+		return 0;
+	return s_cur->base[s_cur->font.widths_table + (int32_t)idx];
+}
+
+static bool is_stop(uint8_t c)
+{
+	return c == 0 || c == s_alt_stop || c < s_first_printable;
+}
+
+unsigned int fontlib_GetStringWidthL(const char* str, unsigned int max_characters)
+{
+	if (!str)
+		return 0;
+	unsigned int w = 0;
+	for (unsigned int i = 0; i < max_characters && !is_stop((uint8_t)str[i]); ++i)
+		w += fontlib_GetGlyphWidth(str[i]);
+	return w;
+}
+
+unsigned int fontlib_GetStringWidth(const char* str)
+{
+	return fontlib_GetStringWidthL(str, (unsigned int)-1);
+}
+
+unsigned int fontlib_DrawGlyph(uint8_t glyph)
+{
+	const uint64_t t0 = host_now_ns();
+	unsigned int idx = 0;
+	if (!glyph_index(glyph, &idx))
+		return (unsigned int)s_cursor_x;
+
+	const fontlib_font_t* f = &s_cur->font;
+	const uint8_t* base = s_cur->base;
+	const uint8_t width = base[f->widths_table + (int32_t)idx];
+	const uint16_t bmp_off =
+	    (uint16_t)(base[f->bitmaps + (int32_t)(idx * 2U)] | (base[f->bitmaps + (int32_t)(idx * 2U) + 1] << 8));
+	const uint8_t* bmp = base + bmp_off;
+	const int bytes_per_row = (width + 7) / 8;
+
+	HostClip clip = host_gfx_clip();
+	if (clip.xmin < s_win_x)
+		clip.xmin = s_win_x;
+	if (clip.ymin < s_win_y)
+		clip.ymin = s_win_y;
+	if (clip.xmax > s_win_x + s_win_w)
+		clip.xmax = s_win_x + s_win_w;
+	if (clip.ymax > s_win_y + s_win_h)
+		clip.ymax = s_win_y + s_win_h;
+
+	uint8_t* fb = host_gfx_target();
+	const int y0 = s_cursor_y + s_space_above;
+	if (!s_transparent)
+	{
+		for (int r = 0; r < s_space_above; ++r)
+			for (int c = 0; c < width; ++c)
+				host_gfx_plot(fb, clip, s_cursor_x + c, s_cursor_y + r, s_bg);
+		for (int r = 0; r < s_space_below; ++r)
+			for (int c = 0; c < width; ++c)
+				host_gfx_plot(fb, clip, s_cursor_x + c, y0 + f->height + r, s_bg);
+	}
+	for (int r = 0; r < f->height; ++r)
+	{
+		const uint8_t* row = bmp + (r * bytes_per_row);
+		for (int c = 0; c < width; ++c)
+		{
+			bool on = (row[c >> 3] >> (7 - (c & 7))) & 1U;
+			if (on)
+				host_gfx_plot(fb, clip, s_cursor_x + c, y0 + r, s_fg);
+			else if (!s_transparent)
+				host_gfx_plot(fb, clip, s_cursor_x + c, y0 + r, s_bg);
+		}
+	}
+
+	host_stats_timed(HOST_OP_FONT_GLYPH, t0, (uint64_t)width * f->height);
+	s_cursor_x += width;
+	return (unsigned int)s_cursor_x;
+}
+
+unsigned int fontlib_DrawStringL(const char* str, unsigned int max_characters)
+{
+	if (!str)
+		return (unsigned int)s_cursor_x;
+	for (unsigned int i = 0; i < max_characters && !is_stop((uint8_t)str[i]); ++i)
+		fontlib_DrawGlyph((uint8_t)str[i]);
+	return (unsigned int)s_cursor_x;
+}
+
+unsigned int fontlib_DrawString(const char* str)
+{
+	return fontlib_DrawStringL(str, (unsigned int)-1);
+}
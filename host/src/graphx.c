@@ -0,0 +1,461 @@
+#include "host_gfx.h"
+
+#include <host_stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_FB_SIZE ((size_t)GFX_LCD_WIDTH * GFX_LCD_HEIGHT)
+#define HOST_CHAR_W 8
+#define HOST_CHAR_H 8
+
+uint16_t gfx_palette[256];
+
+static uint8_t s_fb[2][HOST_FB_SIZE];
+static int s_front = 0;
+static bool s_draw_to_buffer = false;
+static uint8_t s_color = 0;
+static uint8_t s_transparent = 0;
+static uint8_t s_text_fg = 0;
+static uint8_t s_text_bg = 255;
+static uint8_t s_text_transparent = 255;
+static int s_text_x = 0;
+static int s_text_y = 0;
+static HostClip s_clip = { 0, 0, GFX_LCD_WIDTH, GFX_LCD_HEIGHT };
+static char s_frame_dir[1024];
+static uint8_t s_last_frame[HOST_FB_SIZE];
+static bool s_have_last_frame = false;
+static unsigned int s_frames_written = 0;
+
+uint8_t* host_gfx_target(void)
+{
+	return s_fb[s_draw_to_buffer ? (1 - s_front) : s_front];
+}
+
+const uint8_t* host_gfx_front(void)
+{
+	return s_fb[s_front];
+}
+
+HostClip host_gfx_clip(void)
+{
+	return s_clip;
+}
+
+static void fill_span(int x, int y, int w, int h, uint8_t color)
+{
+	const uint64_t t0 = host_now_ns();
+	int x0 = (x < s_clip.xmin) ? s_clip.xmin : x;
+	int y0 = (y < s_clip.ymin) ? s_clip.ymin : y;
+	int x1 = (x + w > s_clip.xmax) ? s_clip.xmax : x + w;
+	int y1 = (y + h > s_clip.ymax) ? s_clip.ymax : y + h;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	uint8_t* fb = host_gfx_target();
+	for (int yy = y0; yy < y1; ++yy)
+		memset(fb + (yy * GFX_LCD_WIDTH) + x0, color, (size_t)(x1 - x0));
+	host_stats_timed(HOST_OP_GFX_FILL, t0, (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0));
+}
+
+void gfx_Begin(void)
+{
+	/* Approximates the default xlibc palette with an RGB 3-3-2 ramp. */
+	for (int i = 0; i < 256; ++i)
+	{
+		int r = ((i >> 5) & 7) * 255 / 7;
+		int g = ((i >> 2) & 7) * 255 / 7;
+		int b = (i & 3) * 255 / 3;
+		gfx_palette[i] = gfx_RGBTo1555(r, g, b);
+	}
+	memset(s_fb, 255, sizeof(s_fb));
+	s_front = 0;
+	s_draw_to_buffer = false;
+	s_clip = (HostClip){ 0, 0, GFX_LCD_WIDTH, GFX_LCD_HEIGHT };
+}
+
+void gfx_End(void)
+{
+}
+
+void gfx_SetDraw(uint8_t location)
+{
+	s_draw_to_buffer = (location == gfx_buffer);
+}
+
+void gfx_SwapDraw(void)
+{
+	const uint64_t t0 = host_now_ns();
+	s_front = 1 - s_front;
+	host_stats_timed(HOST_OP_GFX_SWAP, t0, 0);
+
+	if (!s_frame_dir[0])
+		return;
+	if (s_have_last_frame && memcmp(s_last_frame, s_fb[s_front], HOST_FB_SIZE) == 0)
+		return;
+	memcpy(s_last_frame, s_fb[s_front], HOST_FB_SIZE);
+	s_have_last_frame = true;
+
+	char path[1100];
+	snprintf(path, sizeof(path), "%s/frame_%05u.ppm", s_frame_dir, s_frames_written);
+	if (host_gfx_write_ppm(path))
+		s_frames_written++;
+}
+
+void host_gfx_set_frame_dir(const char* dir)
+{
+	snprintf(s_frame_dir, sizeof(s_frame_dir), "%s", dir ? dir : "");
+	s_have_last_frame = false;
+}
+
+bool host_gfx_write_ppm(const char* path)
+{
+	FILE* f = fopen(path, "wb");
+	if (!f)
+		return false;
+	fprintf(f, "P6\n%d %d\n255\n", GFX_LCD_WIDTH, GFX_LCD_HEIGHT);
+	const uint8_t* fb = s_fb[s_front];
+	for (size_t i = 0; i < HOST_FB_SIZE; ++i)
+	{
+		uint16_t c = gfx_palette[fb[i]];
+		uint8_t rgb[3] = {
+			(uint8_t)(((c >> 10) & 0x1F) * 255 / 31),
+			(uint8_t)(((c >> 5) & 0x1F) * 255 / 31),
+			(uint8_t)((c & 0x1F) * 255 / 31),
+		};
+		fwrite(rgb, 1, sizeof(rgb), f);
+	}
+	return fclose(f) == 0;
+}
+
+unsigned int host_gfx_frames_written(void)
+{
+	return s_frames_written;
+}
+
+void gfx_Wait(void)
+{
+}
+
+void gfx_Blit(uint8_t src)
+{
+	int from = (src == gfx_buffer) ? (1 - s_front) : s_front;
+	memcpy(s_fb[1 - from], s_fb[from], HOST_FB_SIZE);
+}
+
+uint8_t gfx_SetColor(uint8_t index)
+{
+	uint8_t prev = s_color;
+	s_color = index;
+	return prev;
+}
+
+uint8_t gfx_SetTransparentColor(uint8_t index)
+{
+	uint8_t prev = s_transparent;
+	s_transparent = index;
+	return prev;
+}
+
+void gfx_FillScreen(uint8_t index)
+{
+	const uint64_t t0 = host_now_ns();
+	memset(host_gfx_target(), index, HOST_FB_SIZE);
+	host_stats_timed(HOST_OP_GFX_FILL, t0, HOST_FB_SIZE);
+}
+
+void gfx_ZeroScreen(void)
+{
+	gfx_FillScreen(0);
+}
+
+void gfx_SetClipRegion(int xmin, int ymin, int xmax, int ymax)
+{
+	s_clip.xmin = (xmin < 0) ? 0 : xmin;
+	s_clip.ymin = (ymin < 0) ? 0 : ymin;
+	s_clip.xmax = (xmax > GFX_LCD_WIDTH) ? GFX_LCD_WIDTH : xmax;
+	s_clip.ymax = (ymax > GFX_LCD_HEIGHT) ? GFX_LCD_HEIGHT : ymax;
+}
+
+void gfx_SetPixel(uint24_t x, uint8_t y)
+{
+	const uint64_t t0 = host_now_ns();
+	host_gfx_plot(host_gfx_target(), s_clip, (int)x, (int)y, s_color);
+	host_stats_timed(HOST_OP_GFX_PIXEL, t0, 1);
+}
+
+uint8_t gfx_GetPixel(uint24_t x, uint8_t y)
+{
+	if (x >= GFX_LCD_WIDTH || y >= GFX_LCD_HEIGHT)
+		return 0;
+	return host_gfx_target()[(y * GFX_LCD_WIDTH) + x];
+}
+
+void gfx_Line(int x0, int y0, int x1, int y1)
+{
+	const uint64_t t0 = host_now_ns();
+	uint8_t* fb = host_gfx_target();
+	int dx = abs(x1 - x0);
+	int dy = -abs(y1 - y0);
+	int sx = (x0 < x1) ? 1 : -1;
+	int sy = (y0 < y1) ? 1 : -1;
+	int e = dx + dy;
+	uint64_t n = 0;
+	while (true)
+	{
+		host_gfx_plot(fb, s_clip, x0, y0, s_color);
+		n++;
+		if (x0 == x1 && y0 == y1)
+			break;
+		int e2 = 2 * e;
+		if (e2 >= dy)
+		{
+			e += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx)
+		{
+			e += dx;
+			y0 += sy;
+		}
+	}
+	host_stats_timed(HOST_OP_GFX_LINE, t0, n);
+}
+
+void gfx_Line_NoClip(uint24_t x0, uint8_t y0, uint24_t x1, uint8_t y1)
+{
+	gfx_Line((int)x0, (int)y0, (int)x1, (int)y1);
+}
+
+void gfx_HorizLine(int x, int y, int length)
+{
+	fill_span(x, y, length, 1, s_color);
+}
+
+void gfx_HorizLine_NoClip(uint24_t x, uint8_t y, uint24_t length)
+{
+	fill_span((int)x, (int)y, (int)length, 1, s_color);
+}
+
+void gfx_VertLine(int x, int y, int length)
+{
+	fill_span(x, y, 1, length, s_color);
+}
+
+void gfx_VertLine_NoClip(uint24_t x, uint8_t y, uint24_t length)
+{
+	fill_span((int)x, (int)y, 1, (int)length, s_color);
+}
+
+void gfx_Rectangle(int x, int y, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return;
+	fill_span(x, y, width, 1, s_color);
+	fill_span(x, y + height - 1, width, 1, s_color);
+	fill_span(x, y, 1, height, s_color);
+	fill_span(x + width - 1, y, 1, height, s_color);
+}
+
+void gfx_Rectangle_NoClip(uint24_t x, uint8_t y, uint24_t width, uint8_t height)
+{
+	gfx_Rectangle((int)x, (int)y, (int)width, (int)height);
+}
+
+void gfx_FillRectangle(int x, int y, int width, int height)
+{
+	fill_span(x, y, width, height, s_color);
+}
+
+void gfx_FillRectangle_NoClip(uint24_t x, uint8_t y, uint24_t width, uint8_t height)
+{
+	fill_span((int)x, (int)y, (int)width, (int)height, s_color);
+}
+
+void gfx_Circle(int x, int y, uint24_t radius)
+{
+	const uint64_t t0 = host_now_ns();
+	uint8_t* fb = host_gfx_target();
+	int r = (int)radius;
+	int px = r;
+	int py = 0;
+	int err = 1 - r;
+	uint64_t n = 0;
+	while (px >= py)
+	{
+		const int pts[8][2] = { { px, py }, { py, px }, { -py, px }, { -px, py },
+			                    { -px, -py }, { -py, -px }, { py, -px }, { px, -py } };
+		for (int i = 0; i < 8; ++i)
+			host_gfx_plot(fb, s_clip, x + pts[i][0], y + pts[i][1], s_color);
+		n += 8;
+		py++;
+		if (err < 0)
+			err += (2 * py) + 1;
+		else
+		{
+			px--;
+			err += 2 * (py - px) + 1;
+		}
+	}
+	host_stats_timed(HOST_OP_GFX_LINE, t0, n);
+}
+
+void gfx_FillCircle(int x, int y, uint24_t radius)
+{
+	int r = (int)radius;
+	for (int dy = -r; dy <= r; ++dy)
+	{
+		int dx = 0;
+		while ((dx + 1) * (dx + 1) + (dy * dy) <= r * r)
+			dx++;
+		fill_span(x - dx, y + dy, (2 * dx) + 1, 1, s_color);
+	}
+}
+
+static void blit_sprite(const gfx_sprite_t* sprite, int x, int y, bool transparent)
+{
+	const uint64_t t0 = host_now_ns();
+	if (!sprite)
+		return;
+	uint8_t* fb = host_gfx_target();
+	for (int sy = 0; sy < sprite->height; ++sy)
+	{
+		for (int sx = 0; sx < sprite->width; ++sx)
+		{
+			uint8_t c = sprite->data[(sy * sprite->width) + sx];
+			if (transparent && c == s_transparent)
+				continue;
+			host_gfx_plot(fb, s_clip, x + sx, y + sy, c);
+		}
+	}
+	host_stats_timed(HOST_OP_GFX_SPRITE, t0, (uint64_t)sprite->width * sprite->height);
+}
+
+void gfx_Sprite(const gfx_sprite_t* sprite, int x, int y)
+{
+	blit_sprite(sprite, x, y, false);
+}
+
+void gfx_Sprite_NoClip(const gfx_sprite_t* sprite, uint24_t x, uint8_t y)
+{
+	blit_sprite(sprite, (int)x, (int)y, false);
+}
+
+void gfx_TransparentSprite(const gfx_sprite_t* sprite, int x, int y)
+{
+	blit_sprite(sprite, x, y, true);
+}
+
+void gfx_TransparentSprite_NoClip(const gfx_sprite_t* sprite, uint24_t x, uint8_t y)
+{
+	blit_sprite(sprite, (int)x, (int)y, true);
+}
+
+gfx_sprite_t* gfx_GetSprite(gfx_sprite_t* sprite_buffer, int x, int y)
+{
+	if (!sprite_buffer)
+		return NULL;
+	const uint8_t* fb = host_gfx_target();
+	for (int sy = 0; sy < sprite_buffer->height; ++sy)
+	{
+		for (int sx = 0; sx < sprite_buffer->width; ++sx)
+		{
+			int px = x + sx;
+			int py = y + sy;
+			bool inside = px >= 0 && px < GFX_LCD_WIDTH && py >= 0 && py < GFX_LCD_HEIGHT;
+			sprite_buffer->data[(sy * sprite_buffer->width) + sx] = inside ? fb[(py * GFX_LCD_WIDTH) + px] : 0;
+		}
+	}
+	return sprite_buffer;
+}
+
+uint8_t gfx_SetTextFGColor(uint8_t color)
+{
+	uint8_t prev = s_text_fg;
+	s_text_fg = color;
+	return prev;
+}
+
+uint8_t gfx_SetTextBGColor(uint8_t color)
+{
+	uint8_t prev = s_text_bg;
+	s_text_bg = color;
+	return prev;
+}
+
+uint8_t gfx_SetTextTransparentColor(uint8_t color)
+{
+	uint8_t prev = s_text_transparent;
+	s_text_transparent = color;
+	return prev;
+}
+
+void gfx_SetTextXY(int x, int y)
+{
+	s_text_x = x;
+	s_text_y = y;
+}
+
+int gfx_GetTextX(void)
+{
+	return s_text_x;
+}
+
+int gfx_GetTextY(void)
+{
+	return s_text_y;
+}
+
+/* Characters are drawn as solid cells; layout and cost matter here, not legibility. */
+void gfx_PrintChar(const char c)
+{
+	const uint64_t t0 = host_now_ns();
+	if (c != ' ')
+	{
+		uint8_t* fb = host_gfx_target();
+		for (int yy = 1; yy < HOST_CHAR_H - 1; ++yy)
+			for (int xx = 1; xx < HOST_CHAR_W - 2; ++xx)
+				host_gfx_plot(fb, s_clip, s_text_x + xx, s_text_y + yy, s_text_fg);
+	}
+	s_text_x += HOST_CHAR_W;
+	host_stats_timed(HOST_OP_GFX_TEXT, t0, HOST_CHAR_W * HOST_CHAR_H);
+}
+
+void gfx_PrintString(const char* string)
+{
+	if (!string)
+		return;
+	while (*string)
+		gfx_PrintChar(*string++);
+}
+
+void gfx_PrintStringXY(const char* string, int x, int y)
+{
+	gfx_SetTextXY(x, y);
+	gfx_PrintString(string);
+}
+
+void gfx_PrintInt(int n, uint8_t length)
+{
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%0*d", (int)length, n);
+	gfx_PrintString(buf);
+}
+
+void gfx_PrintUInt(unsigned int n, uint8_t length)
+{
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%0*u", (int)length, n);
+	gfx_PrintString(buf);
+}
+
+unsigned int gfx_GetStringWidth(const char* string)
+{
+	return string ? (unsigned int)(strlen(string) * HOST_CHAR_W) : 0;
+}
+
+unsigned int gfx_GetCharWidth(const char c)
+{
+	(void)c;
+	return HOST_CHAR_W;
+}
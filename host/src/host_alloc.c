@@ -0,0 +1,134 @@
+#include <host_alloc.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#define HOST_ALLOC_MAGIC 0x4E545841U
+#define HOST_ALLOC_HEADER 16U
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t pad;
+	size_t size;
+} AllocHeader;
+
+static HostAllocStats s_stats;
+static size_t s_watch_min = 0;
+static void* s_watch_ptr = NULL;
+static size_t s_watch_size = 0;
+
+static void note_alloc(void* user, size_t size)
+{
+	s_stats.live_bytes += size;
+	s_stats.alloc_count++;
+	s_stats.alloc_bytes += size;
+	if (s_stats.live_bytes > s_stats.peak_bytes)
+		s_stats.peak_bytes = s_stats.live_bytes;
+	if (s_watch_min && !s_watch_ptr && size >= s_watch_min)
+	{
+		s_watch_ptr = user;
+		s_watch_size = size;
+	}
+}
+
+static AllocHeader* header_of(void* user)
+{
+	AllocHeader* h = (AllocHeader*)((uint8_t*)user - HOST_ALLOC_HEADER);
+	return (h->magic == HOST_ALLOC_MAGIC) ? h : NULL;
+}
+
+void* __wrap_malloc(size_t size)
+{
+	uint8_t* raw = (uint8_t*)__real_malloc(size + HOST_ALLOC_HEADER);
+	if (!raw)
+		return NULL;
+	AllocHeader* h = (AllocHeader*)raw;
+	h->magic = HOST_ALLOC_MAGIC;
+	h->size = size;
+	note_alloc(raw + HOST_ALLOC_HEADER, size);
+	return raw + HOST_ALLOC_HEADER;
+}
+
+void* __wrap_calloc(size_t n, size_t size)
+{
+	if (size && n > ((size_t)-1 - HOST_ALLOC_HEADER) / size)
+		return NULL;
+	void* p = __wrap_malloc(n * size);
+	if (p)
+		memset(p, 0, n * size);
+	return p;
+}
+
+void __wrap_free(void* ptr)
+{
+	if (!ptr)
+		return;
+	AllocHeader* h = header_of(ptr);
+	if (!h)
+	{
+		/* Memory handed out by libc internals (scandir, strdup, ...). */
+		__real_free(ptr);
+		return;
+	}
+	s_stats.live_bytes -= h->size;
+	s_stats.free_count++;
+	if (ptr == s_watch_ptr)
+		s_watch_ptr = NULL;
+	h->magic = 0;
+	__real_free(h);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	if (!ptr)
+		return __wrap_malloc(size);
+	if (size == 0)
+	{
+		__wrap_free(ptr);
+		return NULL;
+	}
+	AllocHeader* h = header_of(ptr);
+	if (!h)
+		return __real_realloc(ptr, size);
+
+	void* next = __wrap_malloc(size);
+	if (!next)
+		return NULL;
+	memcpy(next, ptr, (h->size < size) ? h->size : size);
+	__wrap_free(ptr);
+	return next;
+}
+
+HostAllocStats host_alloc_stats(void)
+{
+	return s_stats;
+}
+
+void host_alloc_reset_peak(void)
+{
+	s_stats.peak_bytes = s_stats.live_bytes;
+	s_stats.alloc_count = 0;
+	s_stats.alloc_bytes = 0;
+	s_stats.free_count = 0;
+}
+
+void host_alloc_watch(size_t min_size)
+{
+	s_watch_min = min_size;
+	s_watch_ptr = NULL;
+	s_watch_size = 0;
+}
+
+void* host_alloc_watched(size_t* out_size)
+{
+	s_watch_min = 0;
+	if (out_size)
+		*out_size = s_watch_ptr ? s_watch_size : 0;
+	return s_watch_ptr;
+}
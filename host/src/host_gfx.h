@@ -0,0 +1,28 @@
+#ifndef HOST_GFX_H
+#define HOST_GFX_H
+
+/* Framebuffer state shared between the graphx and fontlibc stand-ins. */
+
+#include <graphx.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+	int xmin;
+	int ymin;
+	int xmax;
+	int ymax;
+} HostClip;
+
+uint8_t* host_gfx_target(void);
+const uint8_t* host_gfx_front(void);
+HostClip host_gfx_clip(void);
+
+static inline void host_gfx_plot(uint8_t* fb, HostClip clip, int x, int y, uint8_t color)
+{
+	if (x >= clip.xmin && x < clip.xmax && y >= clip.ymin && y < clip.ymax)
+		fb[(y * GFX_LCD_WIDTH) + x] = color;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#include <host_stats.h>
+
+#include <string.h>
+
+HostOpStat host_op_stats[HOST_OP_COUNT];
+
+static const char* const s_op_names[HOST_OP_COUNT] = {
+	"gfx_fill",  "gfx_line",  "gfx_pixel", "gfx_text",  "gfx_sprite", "gfx_swap",   "font_glyph",
+	"ti_open",   "ti_read",   "kb_scan",   "ntx_index", "ntx_chunk",  "tex_format", "tex_draw",
+};
+
+void host_stats_reset(void)
+{
+	memset(host_op_stats, 0, sizeof(host_op_stats));
+}
+
+const char* host_op_name(HostOp op)
+{
+	return (op < HOST_OP_COUNT) ? s_op_names[op] : "?";
+}
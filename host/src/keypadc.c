@@ -0,0 +1,180 @@
+/* Scripted keypad. A script is a text file with one command per line:
+ *
+ *   down 3      press and release DOWN three times
+ *   hold up 20  keep UP held for 20 scans
+ *   wait 5      5 scans with no key held
+ *   # comment
+ *
+ * Key names: up down left right enter clear 2nd mode alpha del 0-9.
+ * Once the script runs out CLEAR is pressed repeatedly so every loop in the
+ * viewer unwinds; $NTX_HOST_MAX_SCANS (default 200000) is a hard stop. */
+
+#include <host_stats.h>
+#include <keypadc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_MAX_STEPS 65536U
+
+typedef struct
+{
+	uint8_t group;
+	uint8_t mask;
+} KeyStep;
+
+typedef struct
+{
+	const char* name;
+	uint8_t group;
+	uint8_t mask;
+} KeyName;
+
+static const KeyName s_key_names[] = {
+	{ "up", 7, kb_Up },       { "down", 7, kb_Down },   { "left", 7, kb_Left },   { "right", 7, kb_Right },
+	{ "enter", 6, kb_Enter }, { "clear", 6, kb_Clear }, { "2nd", 1, kb_2nd },     { "mode", 1, kb_Mode },
+	{ "del", 1, kb_Del },     { "alpha", 2, kb_Alpha }, { "0", 3, kb_0 },         { "1", 3, kb_1 },
+	{ "4", 3, kb_4 },         { "7", 3, kb_7 },         { "2", 4, kb_2 },         { "5", 4, kb_5 },
+	{ "8", 4, kb_8 },         { "3", 5, kb_3 },         { "6", 5, kb_6 },         { "9", 5, kb_9 },
+};
+
+uint8_t kb_Data[8];
+
+static KeyStep s_steps[HOST_MAX_STEPS];
+static uint32_t s_step_count = 0;
+static uint32_t s_step_pos = 0;
+static bool s_loaded = false;
+static uint64_t s_scans = 0;
+static uint64_t s_max_scans = 200000;
+
+static bool push_step(uint8_t group, uint8_t mask)
+{
+	if (s_step_count >= HOST_MAX_STEPS)
+		return false;
+	s_steps[s_step_count].group = group;
+	s_steps[s_step_count].mask = mask;
+	s_step_count++;
+	return true;
+}
+
+static const KeyName* find_key(const char* name)
+{
+	for (size_t i = 0; i < sizeof(s_key_names) / sizeof(s_key_names[0]); ++i)
+	{
+		if (strcmp(s_key_names[i].name, name) == 0)
+			return &s_key_names[i];
+	}
+	return NULL;
+}
+
+bool host_keypad_load_script(const char* path)
+{
+	s_loaded = true;
+	s_step_count = 0;
+	s_step_pos = 0;
+
+	const char* max_env = getenv("NTX_HOST_MAX_SCANS");
+	if (max_env && atoll(max_env) > 0)
+		s_max_scans = (uint64_t)atoll(max_env);
+
+	if (!path)
+		path = getenv("NTX_HOST_KEYS");
+	if (!path || !path[0])
+		return true;
+
+	FILE* f = fopen(path, "r");
+	if (!f)
+	{
+		fprintf(stderr, "keypad: cannot open script %s\n", path);
+		return false;
+	}
+
+	char line[128];
+	unsigned int line_no = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), f))
+	{
+		line_no++;
+		char* hash = strchr(line, '#');
+		if (hash)
+			*hash = '\0';
+
+		char a[32] = { 0 };
+		char b[32] = { 0 };
+		char c[32] = { 0 };
+		int n = sscanf(line, "%31s %31s %31s", a, b, c);
+		if (n <= 0)
+			continue;
+
+		if (strcmp(a, "wait") == 0)
+		{
+			long count = (n >= 2) ? atol(b) : 1;
+			for (long i = 0; ok && i < count; ++i)
+				ok = push_step(0, 0);
+			continue;
+		}
+
+		bool hold = strcmp(a, "hold") == 0;
+		const KeyName* key = find_key(hold ? b : a);
+		if (!key)
+		{
+			fprintf(stderr, "keypad: %s:%u: unknown key '%s'\n", path, line_no, hold ? b : a);
+			ok = false;
+			break;
+		}
+		long count = atol(hold ? c : b);
+		if (count <= 0)
+			count = 1;
+		for (long i = 0; ok && i < count; ++i)
+		{
+			ok = push_step(key->group, key->mask);
+			if (ok && !hold)
+				ok = push_step(0, 0);
+		}
+		if (ok && hold)
+			ok = push_step(0, 0);
+	}
+	fclose(f);
+	if (!ok)
+		fprintf(stderr, "keypad: script %s rejected\n", path);
+	return ok;
+}
+
+void kb_Scan(void)
+{
+	const uint64_t t0 = host_now_ns();
+	if (!s_loaded && !host_keypad_load_script(NULL))
+		exit(2);
+
+	if (++s_scans > s_max_scans)
+	{
+		fprintf(stderr, "keypad: scan limit reached (%llu)\n", (unsigned long long)s_max_scans);
+		exit(3);
+	}
+
+	memset(kb_Data, 0, sizeof(kb_Data));
+	if (s_step_pos < s_step_count)
+	{
+		const KeyStep* step = &s_steps[s_step_pos++];
+		kb_Data[step->group] = step->mask;
+	}
+	else if (s_scans & 1U)
+	{
+		kb_Data[6] = kb_Clear;
+	}
+	host_stats_timed(HOST_OP_KB_SCAN, t0, 0);
+}
+
+void kb_Reset(void)
+{
+	memset(kb_Data, 0, sizeof(kb_Data));
+}
+
+uint8_t kb_AnyKey(void)
+{
+	uint8_t any = 0;
+	for (int i = 1; i < 8; ++i)
+		any |= kb_Data[i];
+	return any;
+}
@@ -0,0 +1,354 @@
+/* texdry: formats every chunk of a built pack with the viewer's renderer
+ * configuration and reports per-chunk memory, layout size and cost. */
+
+#include "host_gfx.h"
+#include "ntx_pack.h"
+
+#include <fileioc.h>
+#include <fontlibc.h>
+#include <host_alloc.h>
+#include <host_stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tex/tex.h>
+#include <tex_renderer.h>
+
+#define COL_BG 255
+#define COL_FG 0
+#define SLAB_PAINT 0xA5
+
+/* Coarse eZ80 cost model (48 MHz, code in flash). Only meant to rank chunks
+ * against each other; calibrate against emulator timings when it matters. */
+#define EZ80_CYC_FORMAT_PER_BYTE 450U
+#define EZ80_CYC_PER_ALLOC 900U
+#define EZ80_CYC_PER_GLYPH 700U
+#define EZ80_CYC_PER_GLYPH_PX 14U
+#define EZ80_CYC_PER_FILL_PX 2U
+#define EZ80_CYC_PER_LINE_PX 40U
+/* Draw cost is also reported per slice of the scroll range, to show whether
+ * tex_draw's cost grows with how far down the chunk the viewport is. */
+#define DRAW_DEPTH_BUCKETS 8
+
+typedef struct
+{
+	const char* vars;
+	const char* index_name;
+	const char* out_path;
+	int width;
+	int margin;
+	int header_h;
+	int viewport_h;
+	int scroll_step;
+	size_t slab_size;
+} DryOptions;
+
+typedef struct
+{
+	uint64_t glyphs;
+	uint64_t glyph_px;
+	uint64_t fill_px;
+	uint64_t line_px;
+} DrawCost;
+
+static void usage(void)
+{
+	fprintf(stderr,
+	        "usage: texdry [--vars DIR[:DIR...]] [--index NAME] [--width PX] [--viewport PX]\n"
+	        "              [--scroll-step PX] [--slab BYTES] [--out PATH]\n");
+}
+
+static bool parse_args(int argc, char** argv, DryOptions* o)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* a = argv[i];
+		const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if (!v)
+			return false;
+		if (strcmp(a, "--vars") == 0)
+			o->vars = v;
+		else if (strcmp(a, "--index") == 0)
+			o->index_name = v;
+		else if (strcmp(a, "--out") == 0)
+			o->out_path = v;
+		else if (strcmp(a, "--width") == 0)
+			o->width = atoi(v);
+		else if (strcmp(a, "--viewport") == 0)
+			o->viewport_h = atoi(v);
+		else if (strcmp(a, "--scroll-step") == 0)
+			o->scroll_step = atoi(v);
+		else if (strcmp(a, "--slab") == 0)
+			o->slab_size = (size_t)strtoul(v, NULL, 10);
+		else
+			return false;
+		i++;
+	}
+	return o->width > 0 && o->viewport_h > 0 && o->scroll_step > 0 && o->slab_size > 0;
+}
+
+static DrawCost draw_cost_snapshot(void)
+{
+	DrawCost c = {
+		.glyphs = host_op_stats[HOST_OP_FONT_GLYPH].calls,
+		.glyph_px = host_op_stats[HOST_OP_FONT_GLYPH].pixels,
+		.fill_px = host_op_stats[HOST_OP_GFX_FILL].pixels + host_op_stats[HOST_OP_GFX_SPRITE].pixels,
+		.line_px = host_op_stats[HOST_OP_GFX_LINE].pixels + host_op_stats[HOST_OP_GFX_PIXEL].pixels,
+	};
+	return c;
+}
+
+static uint64_t draw_cycles(const DrawCost* c)
+{
+	return (c->glyphs * EZ80_CYC_PER_GLYPH) + (c->glyph_px * EZ80_CYC_PER_GLYPH_PX) +
+	       (c->fill_px * EZ80_CYC_PER_FILL_PX) + (c->line_px * EZ80_CYC_PER_LINE_PX);
+}
+
+static void print_u64_array(FILE* out, const char* key, const uint64_t* v, int n)
+{
+	fprintf(out, ", \"%s\": [", key);
+	for (int i = 0; i < n; ++i)
+		fprintf(out, "%s%llu", (i > 0) ? ", " : "", (unsigned long long)v[i]);
+	fputc(']', out);
+}
+
+/* Returns the span of slab bytes written since the slab was painted. */
+static size_t slab_used(const uint8_t* slab, size_t size)
+{
+	if (!slab)
+		return 0;
+	size_t lo = 0;
+	while (lo < size && slab[lo] == SLAB_PAINT)
+		lo++;
+	if (lo == size)
+		return 0;
+	size_t hi = size;
+	while (hi > lo && slab[hi - 1] == SLAB_PAINT)
+		hi--;
+	return hi - lo;
+}
+
+static void dry_run_chunk(FILE* out, const DryOptions* o, TeX_Renderer* renderer, uint8_t* slab, size_t slab_size,
+                          char* text, uint16_t text_cap, const NtxIndex* idx, const NtxNoteEntry* note,
+                          uint16_t note_index, uint32_t chunk, bool first)
+{
+	char err[64] = { 0 };
+	const char* chunk_text = NULL;
+	uint16_t text_len = 0;
+	uint8_t split_kind = 0;
+
+	fprintf(out, "%s\n    {\"note_index\": %u, \"note_id\": %u, \"chunk\": %lu", first ? "" : ",", (unsigned)note_index,
+	        (unsigned)note->note_id, (unsigned long)chunk);
+
+	if (!ntx_load_chunk_text(idx, note, chunk, text, text_cap, &chunk_text, &text_len, &split_kind, err, sizeof(err)))
+	{
+		fprintf(out, ", \"ok\": false, \"error\": \"load: %s\"}", err);
+		return;
+	}
+
+	TeX_Config cfg = {
+		.color_fg = COL_FG,
+		.color_bg = COL_BG,
+		.font_pack = "TeXFonts",
+		.error_callback = NULL,
+		.error_userdata = NULL,
+	};
+
+	const HostAllocStats base = host_alloc_stats();
+	host_alloc_reset_peak();
+	const uint64_t t0 = host_now_ns();
+	TeX_Layout* layout = tex_format(chunk_text, o->width, &cfg);
+	const uint64_t t1 = host_now_ns();
+	const HostAllocStats fmt = host_alloc_stats();
+
+	fprintf(out, ", \"text_bytes\": %u, \"split_kind\": %u", (unsigned)text_len, (unsigned)split_kind);
+	if (!layout)
+	{
+		fprintf(out, ", \"ok\": false, \"error\": \"tex_format failed\", \"format_peak_bytes\": %zu}",
+		        fmt.peak_bytes - base.live_bytes);
+		return;
+	}
+
+	const int total_h = tex_get_total_height(layout);
+	/* What the viewer's scrollbar will use, read back through the pack reader. */
+	NtxChunkPlace place;
+	const unsigned stored_h = ntx_chunk_place(idx, note, chunk, &place, NULL, 0) ? place.height : 0U;
+	const int max_scroll = (total_h > o->viewport_h) ? (total_h - o->viewport_h) : 0;
+
+	tex_renderer_invalidate(renderer);
+	if (slab)
+		memset(slab, SLAB_PAINT, slab_size);
+
+	host_alloc_reset_peak();
+	const HostAllocStats draw_base = host_alloc_stats();
+	uint64_t draw_ns_max = 0;
+	uint64_t draw_cyc_max = 0;
+	uint64_t glyphs_paged = 0;
+	/* Fastest draw per slice: the minimum filters out scheduler noise. */
+	uint64_t depth_ns[DRAW_DEPTH_BUCKETS];
+	uint64_t depth_cyc[DRAW_DEPTH_BUCKETS] = { 0 };
+	for (int b = 0; b < DRAW_DEPTH_BUCKETS; ++b)
+		depth_ns[b] = UINT64_MAX;
+	int next_page = 0;
+	for (int scroll = 0;; scroll += o->scroll_step)
+	{
+		if (scroll > max_scroll)
+			scroll = max_scroll;
+
+		host_stats_reset();
+		gfx_FillScreen(COL_BG);
+		gfx_SetClipRegion(0, o->header_h, GFX_LCD_WIDTH, o->header_h + o->viewport_h);
+		const uint64_t d0 = host_now_ns();
+		tex_draw(renderer, layout, o->margin, o->header_h, scroll);
+		const uint64_t d1 = host_now_ns();
+		gfx_SetClipRegion(0, 0, GFX_LCD_WIDTH, GFX_LCD_HEIGHT);
+
+		const DrawCost cost = draw_cost_snapshot();
+		const uint64_t cyc = draw_cycles(&cost);
+		if (cyc > draw_cyc_max)
+			draw_cyc_max = cyc;
+		if (d1 - d0 > draw_ns_max)
+			draw_ns_max = d1 - d0;
+		const int bucket = (int)(((int64_t)scroll * DRAW_DEPTH_BUCKETS) / (max_scroll + 1));
+		if (d1 - d0 < depth_ns[bucket])
+			depth_ns[bucket] = d1 - d0;
+		if (cyc > depth_cyc[bucket])
+			depth_cyc[bucket] = cyc;
+		if (scroll >= next_page)
+		{
+			glyphs_paged += cost.glyphs;
+			next_page = scroll + o->viewport_h;
+		}
+		if (scroll >= max_scroll)
+			break;
+	}
+	const HostAllocStats drawn = host_alloc_stats();
+
+	const uint64_t fmt_cycles = ((uint64_t)text_len * EZ80_CYC_FORMAT_PER_BYTE) + (fmt.alloc_count * EZ80_CYC_PER_ALLOC);
+	fprintf(out,
+	        ", \"ok\": true, \"height\": %d, \"stored_height\": %u, \"format_us\": %llu, \"format_peak_bytes\": %zu"
+	        ", \"layout_bytes\": %zu, \"layout_allocs\": %llu, \"layout_glyphs\": %llu, \"draw_us_max\": %llu"
+	        ", \"draw_peak_bytes\": %zu, \"slab_size\": %zu, \"slab_used\": %zu, \"est_format_cycles\": %llu"
+	        ", \"est_draw_cycles\": %llu",
+	        total_h, stored_h, (unsigned long long)((t1 - t0) / 1000U), fmt.peak_bytes - base.live_bytes,
+	        fmt.live_bytes - base.live_bytes, (unsigned long long)fmt.alloc_count, (unsigned long long)glyphs_paged,
+	        (unsigned long long)(draw_ns_max / 1000U), drawn.peak_bytes - draw_base.live_bytes, slab ? slab_size : 0,
+	        slab_used(slab, slab_size), (unsigned long long)fmt_cycles, (unsigned long long)draw_cyc_max);
+	for (int b = 0; b < DRAW_DEPTH_BUCKETS; ++b)
+		depth_ns[b] = (depth_ns[b] == UINT64_MAX) ? 0 : depth_ns[b] / 1000U;
+	print_u64_array(out, "draw_us_by_depth", depth_ns, DRAW_DEPTH_BUCKETS);
+	print_u64_array(out, "est_draw_cycles_by_depth", depth_cyc, DRAW_DEPTH_BUCKETS);
+	fputc('}', out);
+
+	tex_free(layout);
+}
+
+int main(int argc, char** argv)
+{
+	DryOptions o = {
+		.vars = NULL,
+		.index_name = NTX_DEFAULT_INDEX,
+		.out_path = NULL,
+		.width = GFX_LCD_WIDTH - 8,
+		.margin = 4,
+		.header_h = 12,
+		.viewport_h = GFX_LCD_HEIGHT - 12 - 10,
+		.scroll_step = 10,
+		.slab_size = (size_t)20 * 1024,
+	};
+	if (!parse_args(argc, argv, &o))
+	{
+		usage();
+		return 2;
+	}
+	if (o.vars)
+		host_fileioc_set_search_path(o.vars);
+
+	gfx_Begin();
+	gfx_SetDrawBuffer();
+	fontlib_SetTransparency(true);
+
+	fontlib_font_t* font_main = fontlib_GetFontByIndex("TeXFonts", 0);
+	fontlib_font_t* font_script = fontlib_GetFontByIndex("TeXScrpt", 0);
+	if (!font_main || !font_script)
+	{
+		fprintf(stderr, "texdry: TeXFonts/TeXScrpt not found in var search path\n");
+		return 1;
+	}
+	tex_draw_set_fonts(font_main, font_script);
+
+	host_alloc_watch(o.slab_size);
+	TeX_Renderer* renderer = tex_renderer_create_sized(o.slab_size);
+	size_t slab_size = 0;
+	uint8_t* slab = (uint8_t*)host_alloc_watched(&slab_size);
+	if (!renderer)
+	{
+		fprintf(stderr, "texdry: renderer create failed\n");
+		return 1;
+	}
+
+	NtxIndex idx;
+	char err[64] = { 0 };
+	if (!ntx_load_index(o.index_name, &idx, err, sizeof(err)))
+	{
+		fprintf(stderr, "texdry: index load failed: %s\n", err);
+		tex_renderer_destroy(renderer);
+		return 1;
+	}
+
+	/* One buffer for every chunk, as in the viewer. */
+	const uint16_t text_cap = (uint16_t)(idx.max_chunk_len + 1U);
+	char* text = (char*)malloc(text_cap);
+	if (!text)
+	{
+		fprintf(stderr, "texdry: oom chunk buffer\n");
+		ntx_free_index(&idx);
+		tex_renderer_destroy(renderer);
+		return 1;
+	}
+
+	FILE* out = o.out_path ? fopen(o.out_path, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "texdry: cannot write %s\n", o.out_path);
+		free(text);
+		ntx_free_index(&idx);
+		tex_renderer_destroy(renderer);
+		return 1;
+	}
+
+	fprintf(out, "{\n  \"width\": %d,\n  \"viewport\": %d,\n  \"scroll_step\": %d,\n  \"slab_size\": %zu,\n", o.width,
+	        o.viewport_h, o.scroll_step, o.slab_size);
+	fprintf(out, "  \"cycle_model\": {\"format_per_byte\": %u, \"per_alloc\": %u, \"per_glyph\": %u, "
+	             "\"per_glyph_px\": %u, \"per_fill_px\": %u, \"per_line_px\": %u},\n",
+	        EZ80_CYC_FORMAT_PER_BYTE, EZ80_CYC_PER_ALLOC, EZ80_CYC_PER_GLYPH, EZ80_CYC_PER_GLYPH_PX,
+	        EZ80_CYC_PER_FILL_PX, EZ80_CYC_PER_LINE_PX);
+	fprintf(out, "  \"chunks\": [");
+
+	bool first = true;
+	bool index_ok = true;
+	for (uint16_t n = 0; n < idx.count; ++n)
+	{
+		const NtxNoteEntry* note = ntx_index_note(&idx, n, err, sizeof(err));
+		if (!note)
+		{
+			fprintf(stderr, "texdry: note %u: %s\n", (unsigned)n, err);
+			index_ok = false;
+			break;
+		}
+		for (uint32_t c = 0; c < note->total_chunks; ++c)
+		{
+			dry_run_chunk(out, &o, renderer, slab, slab_size, text, text_cap, &idx, note, n, c, first);
+			first = false;
+		}
+	}
+	fprintf(out, "\n  ]\n}\n");
+
+	if (out != stdout)
+		fclose(out);
+	free(text);
+	ntx_free_index(&idx);
+	tex_renderer_destroy(renderer);
+	gfx_End();
+	return index_ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#include <tice.h>
+
+#include <time.h>
+
+void delay(uint16_t msec)
+{
+	struct timespec ts = { msec / 1000, (long)(msec % 1000) * 1000000L };
+	nanosleep(&ts, NULL);
+}
+
+void boot_NewLine(void)
+{
+}
@@ -0,0 +1,197 @@
+/* Runtime glue for notes_viewer_host: configures the stand-ins from the
+ * environment before main() runs, times the viewer's pack and layout calls
+ * through linker wraps, and prints a per-operation report at exit.
+ *
+ *   NTX_HOST_VARS    var search path (default: dist/raw:assets)
+ *   NTX_HOST_KEYS    key script, see keypadc.c
+ *   NTX_HOST_FRAMES  directory for PPM frame dumps (optional)
+ *   NTX_HOST_REPORT  write the report as JSON to this path (default: text on stderr)
+ *   NTX_HOST_MEM_BUDGETS
+ *                    comma-separated name=bytes limits checked at exit, e.g.
+ *                    "chunk=40961,high_water=90000"; names are the NtxMemTag
+ *                    names plus high_water (tracked) and heap_peak (all of
+ *                    malloc, libtexce included). Any overrun exits with 4.
+ */
+
+#include "ntx_mem.h"
+#include "ntx_pack.h"
+
+#include <fileioc.h>
+#include <graphx.h>
+#include <host_alloc.h>
+#include <host_stats.h>
+#include <keypadc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tex/tex.h>
+#include <unistd.h>
+#include <tex_renderer.h>
+
+static uint64_t s_start_ns = 0;
+
+bool __real_ntx_load_index(const char* index_name, NtxIndex* out, char* err, size_t err_len);
+bool __real_ntx_load_chunk_text(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index,
+                                char* buf, uint16_t buf_size, const char** out_text, uint16_t* out_len,
+                                uint8_t* out_split_kind, char* err, size_t err_len);
+TeX_Layout* __real_tex_format(const char* text, int width, const TeX_Config* cfg);
+void __real_tex_draw(TeX_Renderer* renderer, const TeX_Layout* layout, int x, int y, int scroll_y);
+
+bool __wrap_ntx_load_index(const char* index_name, NtxIndex* out, char* err, size_t err_len)
+{
+	const uint64_t t0 = host_now_ns();
+	bool ok = __real_ntx_load_index(index_name, out, err, err_len);
+	host_stats_timed(HOST_OP_NTX_INDEX, t0, 0);
+	return ok;
+}
+
+bool __wrap_ntx_load_chunk_text(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index,
+                                char* buf, uint16_t buf_size, const char** out_text, uint16_t* out_len,
+                                uint8_t* out_split_kind, char* err, size_t err_len)
+{
+	const uint64_t t0 = host_now_ns();
+	bool ok = __real_ntx_load_chunk_text(index, note, chunk_index, buf, buf_size, out_text, out_len,
+	                                     out_split_kind, err, err_len);
+	host_stats_timed(HOST_OP_NTX_CHUNK, t0, (ok && out_len) ? *out_len : 0);
+	return ok;
+}
+
+TeX_Layout* __wrap_tex_format(const char* text, int width, const TeX_Config* cfg)
+{
+	const uint64_t t0 = host_now_ns();
+	TeX_Layout* layout = __real_tex_format(text, width, cfg);
+	host_stats_timed(HOST_OP_TEX_FORMAT, t0, 0);
+	return layout;
+}
+
+void __wrap_tex_draw(TeX_Renderer* renderer, const TeX_Layout* layout, int x, int y, int scroll_y)
+{
+	const uint64_t t0 = host_now_ns();
+	__real_tex_draw(renderer, layout, x, y, scroll_y);
+	host_stats_timed(HOST_OP_TEX_DRAW, t0, 0);
+}
+
+static void print_report(uint64_t wall_ns, const HostAllocStats* heap, const NtxMemStats* mem)
+{
+	fprintf(stderr, "notes_viewer_host: wall %.3f ms, heap peak %zu B, %u frame(s) dumped\n", (double)wall_ns / 1e6,
+	        heap->peak_bytes, host_gfx_frames_written());
+	fprintf(stderr, "  %-12s %10s %12s %14s\n", "op", "calls", "total ms", "units");
+	for (int op = 0; op < HOST_OP_COUNT; ++op)
+	{
+		const HostOpStat* s = &host_op_stats[op];
+		if (!s->calls)
+			continue;
+		fprintf(stderr, "  %-12s %10llu %12.3f %14llu\n", host_op_name((HostOp)op), (unsigned long long)s->calls,
+		        (double)s->ns / 1e6, (unsigned long long)s->pixels);
+	}
+	fprintf(stderr, "  tracked heap: high-water %zu B, live %zu B, %lu alloc(s), %lu failure(s)\n", mem->high_water,
+	        mem->live_total, (unsigned long)mem->allocs, (unsigned long)mem->failures);
+	for (int tag = 0; tag < NTX_MEM_TAG_COUNT; ++tag)
+		fprintf(stderr, "    %-10s peak %8zu B  live %8zu B\n", ntx_mem_tag_name((NtxMemTag)tag), mem->peak[tag],
+		        mem->live[tag]);
+}
+
+/* Checks NTX_HOST_MEM_BUDGETS; returns the number of budgets exceeded. */
+static int check_mem_budgets(const NtxMemStats* mem, const HostAllocStats* heap)
+{
+	const char* spec = getenv("NTX_HOST_MEM_BUDGETS");
+	int over = 0;
+	while (spec && *spec)
+	{
+		const char* comma = strchr(spec, ',');
+		const size_t len = comma ? (size_t)(comma - spec) : strlen(spec);
+		char item[64];
+		if (len < sizeof(item))
+		{
+			memcpy(item, spec, len);
+			item[len] = '\0';
+			char* eq = strchr(item, '=');
+			if (eq)
+			{
+				*eq = '\0';
+				const size_t limit = (size_t)strtoul(eq + 1, NULL, 0);
+				bool known = true;
+				size_t used = 0;
+				if (strcmp(item, "high_water") == 0)
+					used = mem->high_water;
+				else if (strcmp(item, "heap_peak") == 0)
+					used = heap->peak_bytes;
+				else
+				{
+					int tag = 0;
+					while (tag < NTX_MEM_TAG_COUNT && strcmp(item, ntx_mem_tag_name((NtxMemTag)tag)) != 0)
+						++tag;
+					known = tag < NTX_MEM_TAG_COUNT;
+					if (known)
+						used = mem->peak[tag];
+				}
+				if (!known)
+					fprintf(stderr, "notes_viewer_host: unknown memory budget '%s'\n", item);
+				else if (used > limit)
+				{
+					fprintf(stderr, "notes_viewer_host: %s peak %zu B exceeds budget %zu B\n", item, used, limit);
+					++over;
+				}
+			}
+		}
+		spec = comma ? comma + 1 : NULL;
+	}
+	return over;
+}
+
+static void write_report(void)
+{
+	const uint64_t wall_ns = host_now_ns() - s_start_ns;
+	const HostAllocStats heap = host_alloc_stats();
+	const char* path = getenv("NTX_HOST_REPORT");
+	NtxMemStats mem;
+	ntx_mem_stats(&mem);
+	const int over_budget = check_mem_budgets(&mem, &heap);
+
+	FILE* f = (path && path[0]) ? fopen(path, "w") : NULL;
+	if (f)
+	{
+		fprintf(f, "{\n  \"wall_us\": %llu,\n  \"frames_written\": %u,\n", (unsigned long long)(wall_ns / 1000U),
+		        host_gfx_frames_written());
+		fprintf(f, "  \"heap\": {\"peak_bytes\": %zu, \"live_bytes\": %zu, \"allocs\": %llu},\n", heap.peak_bytes,
+		        heap.live_bytes, (unsigned long long)heap.alloc_count);
+		fprintf(f, "  \"tracked\": {\"high_water\": %zu, \"live\": %zu, \"allocs\": %lu, \"failures\": %lu, \"tags\": {",
+		        mem.high_water, mem.live_total, (unsigned long)mem.allocs, (unsigned long)mem.failures);
+		for (int tag = 0; tag < NTX_MEM_TAG_COUNT; ++tag)
+			fprintf(f, "%s\n    \"%s\": {\"peak\": %zu, \"live\": %zu}", tag ? "," : "",
+			        ntx_mem_tag_name((NtxMemTag)tag), mem.peak[tag], mem.live[tag]);
+		fprintf(f, "\n  }},\n  \"over_budget\": %d,\n", over_budget);
+		fprintf(f, "  \"ops\": {");
+		for (int op = 0; op < HOST_OP_COUNT; ++op)
+		{
+			const HostOpStat* s = &host_op_stats[op];
+			fprintf(f, "%s\n    \"%s\": {\"calls\": %llu, \"us\": %llu, \"units\": %llu}", op ? "," : "",
+			        host_op_name((HostOp)op), (unsigned long long)s->calls, (unsigned long long)(s->ns / 1000U),
+			        (unsigned long long)s->pixels);
+		}
+		fprintf(f, "\n  }\n}\n");
+		fclose(f);
+	}
+	else
+		print_report(wall_ns, &heap, &mem);
+
+	/* Runs from atexit, so exit() must not be called again. */
+	if (over_budget)
+		_exit(4);
+}
+
+__attribute__((constructor)) static void viewer_host_init(void)
+{
+	const char* vars = getenv("NTX_HOST_VARS");
+	host_fileioc_set_search_path((vars && vars[0]) ? vars : "dist/raw:assets");
+
+	const char* frames = getenv("NTX_HOST_FRAMES");
+	if (frames && frames[0])
+		host_gfx_set_frame_dir(frames);
+
+	if (!host_keypad_load_script(NULL))
+		exit(2);
+
+	s_start_ns = host_now_ns();
+	atexit(write_report);
+}
@@ -3,17 +3,42 @@ from __future__ import annotations
 
 import argparse
 import bisect
+import hashlib
 import json
+import os
 import re
 import struct
 import subprocess
 import sys
+import time
+from concurrent.futures import ProcessPoolExecutor, ThreadPoolExecutor
+from contextlib import contextmanager
 from dataclasses import dataclass
 from pathlib import Path
 
+from ti8x import appvar_bytes, appvar_entry, file_bytes
+
 OS_VAR_MAX_SIZE = 65512
-INDEX_NAME = "NTXIDX"
-PART_PREFIX = "NTX"
+# A pack's AppVars are <prefix>IDX and <prefix> plus the part id as four
+# base-36 digits (<prefix>0001..<prefix>1EKF); the prefix keeps several packs
+# apart on one calculator and is stored in the index header.
+DEFAULT_PREFIX = "NTX"
+PREFIX_RE = re.compile(r"^[A-Z][A-Z0-9]{0,3}$")
+PART_ID_DIGITS = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+MAX_PART_ID = 0xFFFF  # u16 in the index entry; fits in four base-36 digits
+MAX_NOTES = 0xFFFF
+MAX_CHUNKS = 0xFFFFFFFF  # u32 chunk numbers per note and across the pack
+# Note entries live in shard AppVars <prefix>S000.. (three base-36 digits; a
+# part name never starts with S), listed by the small root <prefix>IDX. The
+# viewer loads a shard only when the menu reaches its notes.
+DEFAULT_SHARD_BYTES = 2048
+MAX_SHARDS = 36**3
+
+# Must match the viewer (viewer/src/main.c): LCD width minus two 4 px margins,
+# viewport between the 12 px header and 10 px footer, and the renderer slab.
+VIEWER_CONTENT_WIDTH = 320 - (4 * 2)
+VIEWER_VIEWPORT_HEIGHT = 240 - 12 - 10
+VIEWER_RENDERER_SLAB = 20 * 1024
 
 SPLIT_NONE = 0
 SPLIT_SENTENCE = 1
@@ -21,14 +46,69 @@ SPLIT_PARAGRAPH = 2
 SPLIT_WHITESPACE = 3
 SPLIT_HARD = 4
 
-PART_HEADER_FMT = "<4sHHHHHHHHHH"
+# Bump when split_note (its pre-pass included) or collect_used_commands changes
+# output for the same input, so cached splits from older packers are not reused.
+SPLIT_CACHE_VERSION = 5
+
+INDEX_VERSION = 5
+SHARD_VERSION = 1
+PART_VERSION = 3
+# The header's first_chunk (u32) numbers the part's first chunk within its
+# note; entries follow in order, so a chunk is found without a table scan.
+# Each entry is offset, length, split kind, pad and the chunk's rendered
+# height in pixels at --content-width (0: not measured), which the viewer sums
+# for a note-wide scrollbar without formatting other chunks.
+PART_HEADER_FMT = "<4sHHHHHHHHHHI"
 PART_ENTRY_FMT = "<HHBBH"
-INDEX_HEADER_FMT = "<4sHHHHI"
-INDEX_ENTRY_FIXED_FMT = "<HHHHIBB"
+MAX_CHUNK_HEIGHT = 0xFFFF
+# magic, version, header size, note count, shard count, pack prefix
+# (NUL-padded), then the buffer sizes the viewer allocates once: max chunk
+# bytes, max part bytes, max layout heap; last the dictionary entry count.
+# One root shard record per shard follows: first note, note count, chunk
+# count.
+INDEX_HEADER_FMT = "<4sHHHH4sHHIH"
+ROOT_SHARD_FMT = "<HHI"
+# magic, version, header size, first note, note count; then note entries
+# (fixed part plus title bytes).
+SHARD_HEADER_FMT = "<4sHHHH"
+INDEX_ENTRY_FIXED_FMT = "<HHHIIBB"
+
+# Chunks are coded against one dictionary, <prefix>DIC, built from the whole
+# pack. It holds tokens (frequent LaTeX and word sequences such as "\frac{"
+# or "\times10^{") and blocks (paragraphs, $...$ and $$...$$ that repeat).
+# Codes use control bytes that text never contains:
+#   - one of DICT_SHORT_CODES: token 0..25;
+#   - DICT_TOKEN, n (1..255): token 25 + n;
+#   - DICT_REF, hi, lo: entry (hi & 0x7F) << 7 | (lo & 0x7F), with hi and lo
+#     >= 0x80, used for blocks (ids from DICT_TOKEN_SLOTS on).
+# The viewer expands codes into its chunk buffer; max_chunk_len counts
+# expanded bytes. Dictionary: magic, version, header size, entry count,
+# table offset, payload offset, payload size; then (offset, length) per
+# entry.
+DICT_VERSION = 2
+DICT_HEADER_FMT = "<4sHHHHHH"
+DICT_ENTRY_FMT = "<HH"
+DICT_REF = 0x01
+DICT_REF_SIZE = 3
+DICT_TOKEN = 0x02
+DICT_SHORT_CODES = bytes(c for c in range(0x03, 0x20) if c not in (0x09, 0x0A, 0x0D))
+DICT_TOKEN_SLOTS = len(DICT_SHORT_CODES) + 255
+MAX_DICT_ENTRIES = 1 << 14
+DICT_MIN_BYTES = 16
+DICT_TOKEN_MAX_BYTES = 24
+# Tokens are trained on an evenly spaced sample of chunks of about this size.
+DICT_TRAIN_BYTES = 1 << 20
+# Tokens from an earlier build are kept until the text grows or shrinks by
+# more than 1/DICT_RETRAIN_DRIFT; retraining recodes every chunk.
+DICT_RETRAIN_DRIFT = 8
 
 PART_HEADER_SIZE = struct.calcsize(PART_HEADER_FMT)
 PART_ENTRY_SIZE = struct.calcsize(PART_ENTRY_FMT)
 INDEX_HEADER_SIZE = struct.calcsize(INDEX_HEADER_FMT)
+ROOT_SHARD_SIZE = struct.calcsize(ROOT_SHARD_FMT)
+SHARD_HEADER_SIZE = struct.calcsize(SHARD_HEADER_FMT)
+DICT_HEADER_SIZE = struct.calcsize(DICT_HEADER_FMT)
+DICT_ENTRY_SIZE = struct.calcsize(DICT_ENTRY_FMT)
 INDEX_ENTRY_FIXED_SIZE = struct.calcsize(INDEX_ENTRY_FIXED_FMT)
 
 
@@ -37,11 +117,17 @@ class Chunk:
     text: str
     kind: int
     idx: int
+    packed: bytes | None = None  # text with dictionary references, when any
+    height: int = 0  # rendered height from --format-dry-run, 0 when unknown
 
     @property
     def data(self) -> bytes:
         return self.text.encode("utf-8")
 
+    @property
+    def stored(self) -> bytes:
+        return self.data if self.packed is None else self.packed
+
 
 @dataclass
 class NoteBuild:
@@ -49,10 +135,20 @@ class NoteBuild:
     title: str
     source: Path
     chunks: list[Chunk]
+    key: str = ""  # file name within the notes dir; ids follow it between builds
+    source_bytes: int = 0
     first_part_id: int = 0
     part_count: int = 0
 
 
+@dataclass
+class ShardBuild:
+    name: str
+    first_note: int
+    note_count: int
+    payload: bytes
+
+
 @dataclass
 class PartBuild:
     name: str
@@ -78,16 +174,158 @@ class LoudWarningCollector:
             print(f"[{idx}] {msg}", file=sys.stderr)
 
 
+class BuildCache:
+    """Reuses work from earlier builds into the same output directory:
+    - splits, keyed by note bytes, source path, splitter limits, --no-minify
+      and SPLIT_CACHE_VERSION, with the commands and warnings they produced;
+    - output files, by the hash, size and mtime of what was last written to
+      each path, so unchanged .bin and .8xv files are not rewritten but ones
+      changed by anything else are;
+    - the dictionary tokens, with the text size they were trained on.
+    Entries not used by a build are dropped when it saves."""
+
+    def __init__(self, path: Path | None) -> None:
+        self.path = path
+        self.splits: dict[str, dict] = {}
+        self.outputs: dict[str, list] = {}  # path -> [digest, size, mtime_ns]
+        self.tokens: dict = {}
+        self.used: set[str] = set()
+        self.hits = 0
+        if path is None or not path.is_file():
+            return
+        try:
+            data = json.loads(path.read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            return
+        if data.get("version") == SPLIT_CACHE_VERSION:
+            self.splits = data.get("splits", {})
+            self.outputs = data.get("outputs", {})
+            self.tokens = data.get("tokens", {})
+
+    def lookup(self, raw: bytes, source: str, target: int, hard: int, minify: bool) -> tuple[str, dict | None]:
+        key = content_hash(f"{source}\0{target}\0{hard}\0{int(minify)}\0".encode("utf-8") + raw)
+        self.used.add(key)
+        entry = self.splits.get(key)
+        if entry is not None:
+            self.hits += 1
+        return key, entry
+
+    def store(self, key: str, entry: dict) -> None:
+        self.splits[key] = entry
+
+    def fresh(self, path: Path, digest: str) -> bool:
+        """True when path still holds the output last recorded with digest.
+        Size and mtime are checked too: a --no-cache build, or anything else,
+        may have rewritten the file without updating this cache."""
+        rec = self.outputs.get(str(path))
+        if not isinstance(rec, list) or rec[0] != digest:
+            return False
+        try:
+            st = path.stat()
+        except OSError:
+            return False
+        return [st.st_size, st.st_mtime_ns] == rec[1:]
+
+    def record(self, path: Path, digest: str) -> None:
+        st = path.stat()
+        self.outputs[str(path)] = [digest, st.st_size, st.st_mtime_ns]
+
+    def save(self) -> None:
+        if self.path is None:
+            return
+        ensure_dir(self.path.parent)
+        splits = {k: v for k, v in self.splits.items() if k in self.used}
+        data = {"version": SPLIT_CACHE_VERSION, "splits": splits, "outputs": self.outputs, "tokens": self.tokens}
+        self.path.write_text(json.dumps(data), encoding="utf-8")
+
+
+class StageTimer:
+    def __init__(self) -> None:
+        self.stages: dict[str, float] = {}
+
+    @contextmanager
+    def stage(self, name: str):
+        t0 = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.stages[name] = round(self.stages.get(name, 0.0) + time.perf_counter() - t0, 3)
+
+    def summary(self) -> str:
+        return ", ".join(f"{k} {v:.2f}s" for k, v in self.stages.items())
+
+
+def split_note(job: tuple[bytes, str, int, int, bool]) -> dict:
+    """Preprocesses and splits one note; runs in a worker process, so it
+    returns plain data."""
+    raw, source, target, hard, minify = job
+    local = LoudWarningCollector()
+    text = raw.decode("utf-8")
+    if minify:
+        text = expand_macros(strip_comments(text), local, source)
+        text = _DISPLAY_RE.sub(r"\1$$", _INLINE_RE.sub(r"\1$", text))
+    text, unmapped = transcode_text(text)
+    for c, n in sorted(unmapped.items()):
+        local.warn(f"{source}: no renderer mapping for U+{ord(c):04X} {c!r} ({n}x); kept as UTF-8")
+    if minify:
+        text = squeeze_math(text)
+    chunks = split_text_deterministic(text=text, target=target, hard=hard, warnings=local, source=source)
+    return {
+        "chunks": [[c.text, c.kind] for c in chunks],
+        "commands": sorted(collect_used_commands(text)),
+        "warnings": local.items,
+        "source_bytes": len(raw),
+    }
+
+
+def split_notes(jobs: list[tuple[bytes, str, int, int, bool]], workers: int) -> list[dict]:
+    """Results come back in job order whatever the worker count, so the
+    build output does not depend on scheduling. Small batches stay in this
+    process, where they finish before a pool would have started."""
+    if workers <= 1 or len(jobs) < 2 * workers:
+        return [split_note(job) for job in jobs]
+    with ProcessPoolExecutor(max_workers=workers) as pool:
+        return list(pool.map(split_note, jobs, chunksize=max(1, len(jobs) // (workers * 4))))
+
+
 def parse_args() -> argparse.Namespace:
     p = argparse.ArgumentParser(description="Build libtexce notes pack AppVars")
     p.add_argument("--root", type=Path, default=Path(__file__).resolve().parents[1])
     p.add_argument("--notes-dir", type=Path)
     p.add_argument("--out-raw", type=Path)
     p.add_argument("--out-8xv", type=Path)
+    p.add_argument("--prefix", default=DEFAULT_PREFIX, help="AppVar name prefix for this pack (1-4 chars, A-Z/0-9)")
     p.add_argument("--target-bytes", type=int, default=40960)
     p.add_argument("--hard-bytes", type=int, default=49152)
-    p.add_argument("--skip-convbin", action="store_true")
+    p.add_argument("--skip-8xv", "--skip-convbin", dest="skip_8xv", action="store_true", help="write only raw .bin")
+    p.add_argument("--manifest", type=Path, help="manifest output path (default: dist/pack_manifest.json)")
     p.add_argument("--latex-commands", type=Path)
+    p.add_argument("--format-dry-run", action="store_true", help="format every chunk on the host with libtexce")
+    p.add_argument("--texdry", type=Path, help="prebuilt texdry binary (default: build host/ with cmake)")
+    p.add_argument("--host-build-dir", type=Path)
+    p.add_argument("--fonts-dir", type=Path)
+    p.add_argument("--content-width", type=int, default=VIEWER_CONTENT_WIDTH)
+    p.add_argument("--renderer-slab", type=int, default=VIEWER_RENDERER_SLAB)
+    p.add_argument("--slab-budget", type=int, default=VIEWER_RENDERER_SLAB)
+    p.add_argument("--layout-budget", type=int, default=0, help="max tex_format heap bytes per chunk (0 = off)")
+    p.add_argument(
+        "--shard-bytes", type=int, default=DEFAULT_SHARD_BYTES, help="target size of each index shard AppVar"
+    )
+    p.add_argument(
+        "--previous",
+        type=Path,
+        help="manifest of the last build sent to calculators (default: the manifest being replaced); keeps ids "
+        "stable and writes a delta group of the changed AppVars",
+    )
+    p.add_argument("--delta-8xg", type=Path, help="delta group output (default: dist/NOTES_DELTA.8xg)")
+    p.add_argument("--jobs", type=int, default=0, help="worker processes for splitting notes (default: CPUs)")
+    p.add_argument("--cache-dir", type=Path, help="build cache directory (default: .cache next to --out-raw)")
+    p.add_argument("--no-cache", action="store_true", help="re-split every note and rewrite every output")
+    p.add_argument("--no-dict", action="store_true", help="store repeated blocks in every chunk that uses them")
+    p.add_argument(
+        "--no-minify", action="store_true", help="keep comments, macros and math spacing as written (for render diffs)"
+    )
+    p.add_argument("--emit-c", type=Path, help="also write the pack as C source for -DNTX_EMBED_PACK=ON builds")
     return p.parse_args()
 
 
@@ -103,64 +341,345 @@ def load_supported_commands(path: Path) -> set[str]:
     return commands
 
 
+# Non-ASCII characters the renderer draws from a TeX command (or plain ASCII).
+# Commands are all in LATEX_COMMANDS_SUPPORTED.md.
+TRANSCODE_ASCII = {
+    "\u00a0": " ", "\u2009": " ", "\u202f": " ", "‘": "'", "’": "'", "“": '"', "”": '"', "′": "'",
+    "−": "-", "…": "...",
+}
+TRANSCODE_COMMANDS = {
+    "×": "times", "·": "cdot", "⋅": "cdot", "÷": "div", "±": "pm", "∓": "mp", "°": "degree", "µ": "mu",
+    "→": "to", "←": "gets", "≤": "le", "≥": "ge", "≠": "ne", "≈": "approx", "≡": "equiv", "∼": "sim",
+    "≅": "cong", "∝": "propto", "∞": "infty", "∫": "int", "∑": "sum", "∏": "prod", "∂": "partial",
+    "∇": "nabla", "∈": "in", "∉": "notin", "∩": "cap", "∪": "cup", "⊂": "subset", "⊆": "subseteq",
+    "∅": "emptyset", "∀": "forall", "∃": "exists", "∠": "angle", "⊥": "perp", "∥": "parallel",
+    "∴": "therefore", "⊕": "oplus", "∗": "ast", "ℏ": "hbar", "ℓ": "ell", "⟨": "langle", "⟩": "rangle",
+    "⌈": "lceil", "⌉": "rceil", "⌊": "lfloor", "⌋": "rfloor", "ς": "sigma", "Ω": "Omega",
+}
+TRANSCODE_COMMANDS.update(
+    zip(
+        "αβγδεζηθικλμνξοπρστυφχψωΓΔΘΛΞΠΣΦΨΩ",
+        "alpha beta gamma delta epsilon zeta eta theta iota kappa lambda mu nu xi omicron pi rho sigma tau upsilon "
+        "phi chi psi omega Gamma Delta Theta Lambda Xi Pi Sigma Phi Psi Omega".split(),
+    )
+)
+_NON_ASCII_RE = re.compile(r"[^\x00-\x7f]")
+_TEXT_ARG_RE = re.compile(r"\\text\s*\{")
+
+
+def _text_args(text: str, a: int, b: int) -> list[tuple[int, int]]:
+    """Ranges of \\text{...} arguments inside the math in text[a:b]."""
+    spans = []
+    for m in _TEXT_ARG_RE.finditer(text, a, b):
+        if spans and m.start() < spans[-1][1]:
+            continue
+        depth = 1
+        i = m.end()
+        while i < b and depth:
+            if text[i] == "\\":
+                i += 1
+            elif text[i] == "{":
+                depth += 1
+            elif text[i] == "}":
+                depth -= 1
+            i += 1
+        spans.append((m.end(), i - 1 if depth == 0 else b))
+    return spans
+
+
+def _tex_regions(text: str) -> list[tuple[int, int, int]]:
+    """Splits text into (start, end, mode) ranges in order: mode 0 is text,
+    1 math (with its dollar signs) and 2 a \\text argument inside math."""
+    regions: list[tuple[int, int, int]] = []
+    pos = 0
+    for a, b in _text_spans(text) + [(len(text), len(text))]:
+        inner = pos
+        for ta, tb in _text_args(text, pos, a):
+            regions += [(inner, ta, 1), (ta, tb, 2)]
+            inner = tb
+        regions += [(inner, a, 1), (a, b, 0)]
+        pos = b
+    return regions
+
+
+def transcode_text(text: str) -> tuple[str, dict[str, int]]:
+    """Rewrites non-ASCII characters as the TeX commands the renderer draws
+    them with: $\\times$ in text, \\times in math and {\\text{a}\\times\\text{b}}
+    inside a \\text argument (one group, so ^\\text{...} keeps all of it as the
+    superscript). Next to inline math the command joins it, so no $$ appears.
+    Returns the new text and a count of each character left as it was because
+    it has no mapping."""
+    if text.isascii():
+        return text, {}
+    unmapped: dict[str, int] = {}
+    regions = _tex_regions(text)
+
+    def spaced(cmd: str, after: str) -> str:
+        return f"\\{cmd} " if after.isascii() and after.isalpha() else f"\\{cmd}"
+
+    out: list[str] = []
+    skip_next = False  # the region starts with a $ or } already written
+    for a, b, mode in regions:
+        if skip_next and a < b:
+            a += 1
+            skip_next = False
+        pos = a
+        grouped = False
+        if mode == 2 and text.startswith("}", b):
+            head = text[text.rfind("\\text", 0, a) : a]
+            mapped = any(m[0] in TRANSCODE_COMMANDS for m in _NON_ASCII_RE.finditer(text, a, b))
+            if mapped and out and out[-1].endswith(head):
+                out[-1] = out[-1][: -len(head)] + "{" + head
+                grouped = True
+        for m in _NON_ASCII_RE.finditer(text, a, b):
+            if pos < m.start():
+                out.append(text[pos : m.start()])
+            pos = m.end()
+            c = m[0]
+            cmd = TRANSCODE_COMMANDS.get(c)
+            if c in TRANSCODE_ASCII:
+                out.append(TRANSCODE_ASCII[c])
+            elif cmd is None:
+                unmapped[c] = unmapped.get(c, 0) + 1
+                out.append(c)
+            elif mode == 1:
+                out.append(spaced(cmd, text[pos : pos + 1]))
+            elif mode == 2:
+                out.append(f"}}\\{cmd}\\text{{")
+            else:
+                prev = "".join(out[-2:])[-2:]
+                if prev.endswith("$$"):
+                    opener = " $"
+                elif prev.endswith("$") and prev != "\\$":
+                    out[-1] = out[-1][:-1]
+                    opener = ""
+                else:
+                    opener = "$"
+                if pos == b and text.startswith("$", b) and not text.startswith("$$", b):
+                    out.append(opener + spaced(cmd, text[b + 1 : b + 2]))
+                    skip_next = True
+                else:
+                    out.append(f"{opener}\\{cmd}$" + (" " if text.startswith("$$", pos) else ""))
+        if pos < b:
+            out.append(text[pos:b])
+        if grouped:
+            out.append("}}")
+            skip_next = True
+    return "".join(out), unmapped
+
+
+# The pre-pass behind --no-minify. Each step keeps what TeX would render.
+# An unescaped % starts a comment that also takes the line end and the next
+# line's indent, unless that line is blank (a paragraph break).
+_COMMENT_RE = re.compile(r"(?<!\\)((?:\\\\)*)%[^\n]*(?:\n[ \t]*(?![ \t\r\n]))?")
+_NEWCOMMAND_RE = re.compile(
+    r"\\(?:re)?newcommand\*?\s*(?:\{\s*\\([A-Za-z]+)\s*\}|\\([A-Za-z]+))\s*(?:\[(\d)\])?\s*(?:\[([^\]]*)\])?\s*\{"
+)
+_DEF_RE = re.compile(r"\\def\s*\\([A-Za-z]+)")
+_DISPLAY_RE = re.compile(r"(?<!\\)((?:\\\\)*)\\[\[\]]")
+_INLINE_RE = re.compile(r"(?<!\\)((?:\\\\)*)\\[()]")
+# Spaces after a control word are skipped, up to one line end.
+_AFTER_WORD_RE = re.compile(r"[ \t]*(?:\n[ \t]*(?![ \t\r\n]))?")
+_MATH_TOKEN_RE = re.compile(r"\\(?:[A-Za-z]+|.)|\s+|[^\\\s]+", re.S)
+MACRO_PASSES = 16
+
+
+def strip_comments(text: str) -> str:
+    return _COMMENT_RE.sub(r"\1", text) if "%" in text else text
+
+
+def _group_end(text: str, i: int) -> int:
+    """Index just past the brace group opening at text[i]; len(text) when it
+    never closes."""
+    depth = 0
+    while i < len(text):
+        if text[i] == "\\":
+            i += 2
+            continue
+        if text[i] == "{":
+            depth += 1
+        elif text[i] == "}":
+            depth -= 1
+            if depth == 0:
+                return i + 1
+        i += 1
+    return len(text)
+
+
+def _macro_args(text: str, pos: int, count: int, default: str | None) -> tuple[list[str], int] | None:
+    args: list[str] = []
+    if default is not None:
+        j = len(text) - len(text[pos:].lstrip())
+        if text.startswith("[", j) and "]" in text[j:]:
+            end = text.index("]", j)
+            args.append(text[j + 1 : end])
+            pos = end + 1
+        else:
+            args.append(default)
+    while len(args) < count:
+        j = len(text) - len(text[pos:].lstrip())
+        if j >= len(text) or text[j] == "}":
+            return None
+        if text[j] == "{":
+            end = _group_end(text, j)
+            args.append(text[j + 1 : end - 1])
+        elif text[j] == "\\":
+            end = j + len(_MATH_TOKEN_RE.match(text, j)[0])
+            args.append(text[j:end])
+        else:
+            end = j + 1
+            args.append(text[j])
+        pos = end
+    return args, pos
+
+
+def expand_macros(text: str, warnings: LoudWarningCollector, source: str) -> str:
+    """Removes \\newcommand/\\renewcommand definitions and expands their uses,
+    including an optional first argument with a default. \\def is left alone."""
+    if "newcommand" not in text:
+        if _DEF_RE.search(text):
+            warnings.warn(f"{source}: \\def macros are not expanded; use \\newcommand")
+        return text
+    macros: dict[str, tuple[int, str | None, str]] = {}
+    out = []
+    pos = 0
+    for m in _NEWCOMMAND_RE.finditer(text):
+        if m.start() < pos:
+            continue
+        end = _group_end(text, m.end() - 1)
+        macros[m[1] or m[2]] = (int(m[3] or 0), m[4], text[m.end() : end - 1])
+        out.append(text[pos : m.start()])
+        pos = end + len(re.match(r"[ \t]*\n?", text[end:])[0])
+    out.append(text[pos:])
+    text = "".join(out)
+    if _DEF_RE.search(text):
+        warnings.warn(f"{source}: \\def macros are not expanded; use \\newcommand")
+    if not macros:
+        return text
+
+    names = "|".join(sorted(map(re.escape, macros), key=len, reverse=True))
+    use_re = re.compile(rf"(?<!\\)((?:\\\\)*)\\({names})(?![A-Za-z])")
+    for _ in range(MACRO_PASSES):
+        out = []
+        pos = 0
+        for m in use_re.finditer(text):
+            if m.start() < pos:
+                continue
+            count, default, body = macros[m[2]]
+            parsed = _macro_args(text, m.end(), count, default)
+            if parsed is None:
+                warnings.warn(f"{source}: \\{m[2]} is missing arguments; left unexpanded")
+                continue
+            args, end = parsed
+            if count == 0:
+                end += len(_AFTER_WORD_RE.match(text, end)[0])
+                if text.startswith("{}", end):
+                    end += 2
+            body = re.sub(r"#([1-9])", lambda a: args[int(a[1]) - 1] if int(a[1]) <= len(args) else a[0], body)
+            if re.search(r"\\[A-Za-z]+$", body) and text[end : end + 1].isalpha():
+                body += " "
+            out += [text[pos : m.start()], m[1], body]
+            pos = end
+        if not out:
+            return text
+        out.append(text[pos:])
+        text = "".join(out)
+    warnings.warn(f"{source}: macros still present after {MACRO_PASSES} expansions; is one recursive?")
+    return text
+
+
+def squeeze_math(text: str) -> str:
+    """Drops whitespace in math, which TeX ignores, but keeps one space
+    between two runs of letters or digits (so \\sin x and ^n x read the same
+    to any parser) and after a \\\\ row break followed by a letter (\\\\ d must
+    not read as \\\\d). \\text arguments keep theirs."""
+    out = []
+    for a, b, mode in _tex_regions(text):
+        if mode != 1:
+            out.append(text[a:b])
+            continue
+        toks = _MATH_TOKEN_RE.findall(text, a, b)
+        for i, tok in enumerate(toks):
+            if not tok[0].isspace():
+                out.append(tok)
+            elif out and toks[i + 1 : i + 2] and toks[i + 1][0].isalnum():
+                prev = out[-1]
+                nxt = toks[i + 1][0]
+                row_break = prev == "\\\\" and nxt.isalpha()
+                if row_break or (prev[-1].isalnum() and (nxt.isalpha() or prev[0] != "\\")):
+                    out.append(" ")
+    return "".join(out)
+
+
 def collect_used_commands(text: str) -> set[str]:
-    return set(re.findall(r"\\([A-Za-z]+)", text))
+    # Skips escaped backslashes, so the row break in \\d is not read as \d.
+    return set(re.findall(r"(?<!\\)(?:\\\\)*\\([A-Za-z]+)", text))
 
 
 def _last_gt_start(bounds: list[int], upper: int, start: int) -> int | None:
+    # bounds is sorted, so only the last one <= upper can also be > start.
     i = bisect.bisect_right(bounds, upper) - 1
-    while i >= 0:
-        if bounds[i] > start:
-            return bounds[i]
-        i -= 1
-    return None
+    return bounds[i] if i >= 0 and bounds[i] > start else None
 
 
-def compute_boundaries(text: str) -> tuple[list[int], list[int], list[int]]:
-    sentence: list[int] = []
-    whitespace: list[int] = []
+_SPACE_RE = re.compile(r"\s")
+_SPACES_RE = re.compile(r"\s*")
+_SENTENCE_END_RE = re.compile(r"[.?!]")
+_PARAGRAPH_RE = re.compile(r"(?:\r?\n[ \t]*){2,}")
 
+
+def _text_spans(text: str) -> list[tuple[int, int]]:
+    """Ranges of text outside $...$ and $$...$$. Only the dollar signs are
+    visited; an unescaped $$ toggles display math even inside inline math, and
+    a single $ inside display math is literal."""
+    spans: list[tuple[int, int]] = []
     in_inline = False
     in_display = False
-    i = 0
-    n = len(text)
+    span_start = 0
+    pos = text.find("$")
+    while pos != -1:
+        if pos > 0 and text[pos - 1] == "\\":
+            pos = text.find("$", pos + 1)
+            continue
+        was_math = in_inline or in_display
+        if text.startswith("$$", pos):
+            in_display = not in_display
+            end = pos + 2
+        elif not in_display:
+            in_inline = not in_inline
+            end = pos + 1
+        else:
+            pos = text.find("$", pos + 1)
+            continue
+        now_math = in_inline or in_display
+        if now_math and not was_math:
+            spans.append((span_start, pos))
+        elif was_math and not now_math:
+            span_start = end
+        pos = text.find("$", end)
+    if not (in_inline or in_display):
+        spans.append((span_start, len(text)))
+    return spans
 
-    while i < n:
-        ch = text[i]
-        prev = text[i - 1] if i > 0 else ""
 
-        if ch == "$" and prev != "\\":
-            if i + 1 < n and text[i + 1] == "$":
-                in_display = not in_display
-                i += 2
-                continue
-            if not in_display:
-                in_inline = not in_inline
-                i += 1
+def compute_boundaries(text: str) -> tuple[list[int], list[int], list[int]]:
+    """Sorted split points after sentence ends, blank lines and whitespace.
+    Sentence and whitespace breaks are only taken outside math; each is found
+    with a compiled regex over the text spans, so the cost is linear."""
+    sentence: list[int] = []
+    whitespace: list[int] = []
+    n = len(text)
+    for a, b in _text_spans(text):
+        whitespace.extend(m.end() for m in _SPACE_RE.finditer(text, a, b))
+        for m in _SENTENCE_END_RE.finditer(text, a, b):
+            # The look-ahead reads past the span: ". $x$" ends a sentence.
+            j = m.end()
+            if j < n and not text[j].isspace():
                 continue
-
-        in_math = in_inline or in_display
-
-        if not in_math:
-            if ch.isspace():
-                whitespace.append(i + 1)
-
-            if ch in ".?!":
-                j = i + 1
-                if j >= n or text[j].isspace():
-                    k = j
-                    while k < n and text[k].isspace():
-                        k += 1
-                    if k >= n or not text[k].islower():
-                        sentence.append(j)
-
-        i += 1
-
-    paragraph = [m.end() for m in re.finditer(r"(?:\r?\n[ \t]*){2,}", text)]
-
-    sentence = sorted(set(sentence))
-    paragraph = sorted(set(paragraph))
-    whitespace = sorted(set(whitespace))
+            k = _SPACES_RE.match(text, j).end()
+            if k >= n or not text[k].islower():
+                sentence.append(j)
+    paragraph = [m.end() for m in _PARAGRAPH_RE.finditer(text)]
     return sentence, paragraph, whitespace
 
 
@@ -223,13 +742,13 @@ def split_text_deterministic(text: str, target: int, hard: int, warnings: LoudWa
     return chunks
 
 
-def partition_into_parts(chunks: list[Chunk]) -> list[list[Chunk]]:
+def partition_into_parts(chunks: list[Chunk], terminate: bool = False) -> list[list[Chunk]]:
     parts: list[list[Chunk]] = []
     cur: list[Chunk] = []
     cur_payload = 0
 
     for chunk in chunks:
-        c_len = len(chunk.data)
+        c_len = len(chunk.stored) + (1 if terminate else 0)
         next_count = len(cur) + 1
         next_payload = cur_payload + c_len
         next_size = PART_HEADER_SIZE + (next_count * PART_ENTRY_SIZE) + next_payload
@@ -256,24 +775,38 @@ def partition_into_parts(chunks: list[Chunk]) -> list[list[Chunk]]:
     return parts
 
 
-def build_part_blob(note_id: int, part_index: int, part_count: int, chunks: list[Chunk]) -> bytes:
+def part_var_name(prefix: str, part_id: int) -> str:
+    if not 1 <= part_id <= MAX_PART_ID:
+        raise RuntimeError(f"part id {part_id} outside 1..{MAX_PART_ID}; split the library into several packs")
+    digits = ""
+    for _ in range(4):
+        part_id, d = divmod(part_id, 36)
+        digits = PART_ID_DIGITS[d] + digits
+    return prefix + digits
+
+
+def build_part_blob(
+    note_id: int, part_index: int, part_count: int, chunks: list[Chunk], terminate: bool = False
+) -> bytes:
     payload_parts: list[bytes] = []
     entries: list[bytes] = []
     rel = 0
 
     for chunk in chunks:
-        data = chunk.data
-        payload_parts.append(data)
+        data = chunk.stored
+        # Compiled-in packs are formatted in place, so each chunk carries a
+        # NUL that the chunk table length does not count.
+        payload_parts.append(data + b"\0" if terminate else data)
         entry = struct.pack(
             PART_ENTRY_FMT,
             rel,
             len(data),
             chunk.kind,
             0,
-            chunk.idx,
+            chunk.height,
         )
         entries.append(entry)
-        rel += len(data)
+        rel += len(payload_parts[-1])
 
     payload = b"".join(payload_parts)
     chunk_table_offset = PART_HEADER_SIZE
@@ -282,7 +815,7 @@ def build_part_blob(note_id: int, part_index: int, part_count: int, chunks: list
     header = struct.pack(
         PART_HEADER_FMT,
         b"NTXP",
-        1,
+        PART_VERSION,
         PART_HEADER_SIZE,
         note_id,
         part_index,
@@ -292,6 +825,7 @@ def build_part_blob(note_id: int, part_index: int, part_count: int, chunks: list
         payload_offset,
         len(payload),
         0,
+        chunks[0].idx,
     )
 
     blob = header + b"".join(entries) + payload
@@ -300,43 +834,351 @@ def build_part_blob(note_id: int, part_index: int, part_count: int, chunks: list
     return blob
 
 
-def build_index_blob(notes: list[NoteBuild]) -> bytes:
-    entries = bytearray()
+def shard_var_name(prefix: str, shard: int) -> str:
+    if not 0 <= shard < MAX_SHARDS:
+        raise RuntimeError(f"{shard + 1} index shards; at most {MAX_SHARDS} (raise --shard-bytes)")
+    digits = ""
+    for _ in range(3):
+        shard, d = divmod(shard, 36)
+        digits = PART_ID_DIGITS[d] + digits
+    return prefix + "S" + digits
+
+
+def note_entry_bytes(note: NoteBuild) -> bytes:
+    title_bytes = note.title.encode("utf-8")
+    if len(title_bytes) > 255:
+        title_bytes = title_bytes[:255]
+
+    fixed = struct.pack(
+        INDEX_ENTRY_FIXED_FMT,
+        note.note_id,
+        note.first_part_id,
+        note.part_count,
+        len(note.chunks),
+        sum(len(c.data) for c in note.chunks),
+        len(title_bytes),
+        0,
+    )
+    return fixed + title_bytes
+
 
+def build_shards(notes: list[NoteBuild], prefix: str, shard_bytes: int) -> list[ShardBuild]:
+    """Packs consecutive note entries into shards of at most shard_bytes."""
+    limit = min(max(shard_bytes, SHARD_HEADER_SIZE + INDEX_ENTRY_FIXED_SIZE + 255), OS_VAR_MAX_SIZE)
+    groups: list[list[bytes]] = []
+    size = limit
     for note in notes:
-        title_bytes = note.title.encode("utf-8")
-        if len(title_bytes) > 255:
-            title_bytes = title_bytes[:255]
-
-        fixed = struct.pack(
-            INDEX_ENTRY_FIXED_FMT,
-            note.note_id,
-            note.first_part_id,
-            note.part_count,
-            len(note.chunks),
-            sum(len(c.data) for c in note.chunks),
-            len(title_bytes),
-            0,
-        )
-        entries.extend(fixed)
-        entries.extend(title_bytes)
+        entry = note_entry_bytes(note)
+        if size + len(entry) > limit:
+            groups.append([])
+            size = SHARD_HEADER_SIZE
+        groups[-1].append(entry)
+        size += len(entry)
+
+    shards: list[ShardBuild] = []
+    first = 0
+    for i, entries in enumerate(groups):
+        header = struct.pack(SHARD_HEADER_FMT, b"NTXS", SHARD_VERSION, SHARD_HEADER_SIZE, first, len(entries))
+        shards.append(ShardBuild(shard_var_name(prefix, i), first, len(entries), header + b"".join(entries)))
+        first += len(entries)
+    return shards
+
+
+def build_index_blob(
+    notes: list[NoteBuild],
+    shards: list[ShardBuild],
+    prefix: str,
+    max_part_size: int,
+    max_layout_bytes: int = 0,
+    dict_count: int = 0,
+) -> bytes:
+    max_chunk_len = max((len(c.data) for n in notes for c in n.chunks), default=0)
+
+    records = bytearray()
+    for shard in shards:
+        chunks = sum(len(n.chunks) for n in notes[shard.first_note : shard.first_note + shard.note_count])
+        records.extend(struct.pack(ROOT_SHARD_FMT, shard.first_note, shard.note_count, chunks))
 
     header = struct.pack(
         INDEX_HEADER_FMT,
         b"NTXI",
-        1,
+        INDEX_VERSION,
         INDEX_HEADER_SIZE,
         len(notes),
-        0,
-        0,
+        len(shards),
+        prefix.encode("ascii"),
+        max_chunk_len,
+        max_part_size,
+        max_layout_bytes,
+        dict_count,
     )
 
-    blob = bytes(header) + bytes(entries)
+    blob = bytes(header) + bytes(records)
     if len(blob) > OS_VAR_MAX_SIZE:
         raise RuntimeError(f"index blob exceeded OS var max: {len(blob)}")
     return blob
 
 
+_DICT_MATH_RE = re.compile(r"\$\$.+?\$\$|\$[^$\n]+\$", re.S)
+_DICT_CODE_RE = re.compile(r"[\x00-\x08\x0b\x0c\x0e-\x1f]")
+# Training units: a command with its opening bracket, an escape, a word with
+# its trailing space, a number, a whitespace run or any other byte.
+_DICT_UNIT_RE = re.compile(rb"\\[A-Za-z]+\s*[{(\[]?|\\.|[A-Za-z]+ ?|[0-9]+|\s+|.", re.S)
+
+
+def _dict_blocks(text: str):
+    """Yields (start, end, inner) for each paragraph of a chunk; inner lists
+    the math spans inside it, tried when the whole paragraph is not shared."""
+    pos = 0
+    for sep in [*_PARAGRAPH_RE.finditer(text), None]:
+        end = sep.start() if sep else len(text)
+        if end > pos:
+            yield pos, end, [(m.start(), m.end()) for m in _DICT_MATH_RE.finditer(text, pos, end)]
+        if sep:
+            pos = sep.end()
+
+
+def _dict_pick(counts: dict[bytes, int], budget: int, limit: int, code_size: int = DICT_REF_SIZE) -> list[bytes]:
+    """Most bytes saved first: each use costs a code, each entry its bytes
+    plus a table slot."""
+    scored = []
+    for block, uses in counts.items():
+        saved = uses * (len(block) - code_size) - len(block) - DICT_ENTRY_SIZE
+        if uses > 1 and saved > 0:
+            scored.append((-saved, block))
+    picked = []
+    for _, block in sorted(scored):
+        if len(picked) >= limit:
+            break
+        if len(block) + DICT_ENTRY_SIZE <= budget:
+            picked.append(block)
+            budget -= len(block) + DICT_ENTRY_SIZE
+    return picked
+
+
+def _stable_slots(items: list[bytes], prev_hashes: list[str], size: int) -> list[bytes]:
+    """Places items in size slots, each in the slot it had in the previous
+    build when it still fits; new items take the free slots in order. Unused
+    slots are empty, so unchanged parts keep their bytes."""
+    slots = [b""] * size
+    old = {h: i for i, h in enumerate(prev_hashes[:size])}
+    fresh = []
+    for item in sorted(items):
+        i = old.get(content_hash(item))
+        if i is not None and not slots[i]:
+            slots[i] = item
+        else:
+            fresh.append(item)
+    free = (i for i, slot in enumerate(slots) if not slot)
+    for item in fresh:
+        slots[next(free)] = item
+    return slots
+
+
+def _token_regex(tokens: list[bytes]) -> re.Pattern:
+    """Matches the longest token at each position; built as a trie so the
+    match costs one pass however many tokens there are."""
+    trie: dict = {}
+    for token in tokens:
+        node = trie
+        for byte in token:
+            node = node.setdefault(byte, {})
+        node[None] = {}
+
+    def emit(node: dict) -> bytes:
+        alts = [re.escape(bytes((b,))) + emit(node[b]) for b in sorted(k for k in node if k is not None)]
+        if not alts:
+            return b""
+        body = alts[0] if len(alts) == 1 else b"(?:" + b"|".join(alts) + b")"
+        return b"(?:" + body + b")?" if None in node else body
+
+    return re.compile(emit(trie), re.S)
+
+
+def _token_uses(texts: list[bytes], tokens: list[bytes]) -> dict[bytes, int]:
+    uses: dict[bytes, int] = {}
+    rx = _token_regex(tokens)
+    for text in texts:
+        for token in rx.findall(text):
+            uses[token] = uses.get(token, 0) + 1
+    return uses
+
+
+def _train_tokens(texts: list[bytes]) -> tuple[list[bytes], list[bytes]]:
+    """Returns (short, long) tokens: runs of one to four units seen in the
+    sample, kept when greedy longest-match coding of the sample shows they
+    save more than they cost. The most used take the one-byte codes."""
+    step = max(1, sum(map(len, texts)) // DICT_TRAIN_BYTES)
+    sample = texts[::step]
+    counts: dict[bytes, int] = {}
+    for text in sample:
+        units = _DICT_UNIT_RE.findall(text)
+        for i in range(len(units)):
+            run = b""
+            for unit in units[i : i + 4]:
+                run += unit
+                if len(run) > DICT_TOKEN_MAX_BYTES:
+                    break
+                if len(run) >= 3:
+                    counts[run] = counts.get(run, 0) + 1
+    candidates = sorted(counts, key=lambda t: (-counts[t] * (len(t) - 1), t))[: 2 * DICT_TOKEN_SLOTS]
+    if not candidates:
+        return [], []
+    # Overlapping candidates share their uses, so score what coding achieves.
+    tokens = _dict_pick(_token_uses(sample, candidates), OS_VAR_MAX_SIZE, DICT_TOKEN_SLOTS, 2)
+    if not tokens:
+        return [], []
+    uses = _token_uses(sample, tokens)
+    tokens.sort(key=lambda t: (-uses.get(t, 0) * (len(t) - 1), t))
+    n = len(DICT_SHORT_CODES)
+    return tokens[:n], tokens[n:]
+
+
+def build_dictionary(
+    notes: list[NoteBuild], prev_hashes: list[str], trained: dict, warnings: LoudWarningCollector
+) -> list[bytes]:
+    """Chooses the shared blocks and tokens and sets chunk.packed to each
+    chunk's coded bytes. Returns the entries in id order; an entry kept from
+    the previous build keeps its id, so unchanged parts do not change bytes.
+    trained holds the tokens of an earlier build and is updated on retraining."""
+    chunks = [c for n in notes for c in n.chunks]
+    if any(_DICT_CODE_RE.search(c.text) for c in chunks):
+        warnings.warn("a note contains control bytes used as dictionary codes; chunks stored uncompressed")
+        return []
+    blocks = [(c, list(_dict_blocks(c.text))) for c in chunks]
+    budget = OS_VAR_MAX_SIZE - DICT_HEADER_SIZE - DICT_TOKEN_SLOTS * (DICT_ENTRY_SIZE + DICT_TOKEN_MAX_BYTES)
+
+    # Whole paragraphs first, then math in the paragraphs that stay.
+    counts: dict[bytes, int] = {}
+    for c, spans in blocks:
+        for a, b, _ in spans:
+            key = c.text[a:b].encode("utf-8")
+            if len(key) >= DICT_MIN_BYTES:
+                counts[key] = counts.get(key, 0) + 1
+    shared = set(_dict_pick(counts, budget, MAX_DICT_ENTRIES - DICT_TOKEN_SLOTS))
+    counts = {}
+    for c, spans in blocks:
+        for a, b, inner in spans:
+            if c.text[a:b].encode("utf-8") not in shared:
+                for ma, mb in inner:
+                    key = c.text[ma:mb].encode("utf-8")
+                    if len(key) >= DICT_MIN_BYTES:
+                        counts[key] = counts.get(key, 0) + 1
+    budget -= sum(len(b) + DICT_ENTRY_SIZE for b in shared)
+    shared.update(_dict_pick(counts, budget, MAX_DICT_ENTRIES - DICT_TOKEN_SLOTS - len(shared)))
+
+    # Each chunk becomes text pieces and shared blocks; tokens code the text.
+    pieces: list[list[bytes | int]] = []
+    for c, spans in blocks:
+        out: list[bytes | int] = []
+        pos = 0
+        for a, b, inner in spans:
+            for ra, rb in [(a, b)] if c.text[a:b].encode("utf-8") in shared else inner:
+                key = c.text[ra:rb].encode("utf-8")
+                if key in shared:
+                    out += [c.text[pos:ra].encode("utf-8"), key]
+                    pos = rb
+        out.append(c.text[pos:].encode("utf-8"))
+        pieces.append(out)
+    texts = [p for out in pieces for i, p in enumerate(out) if i % 2 == 0 and p]
+    size = sum(map(len, texts))
+    if "short" in trained and abs(size - trained["text_bytes"]) * DICT_RETRAIN_DRIFT <= size:
+        short = [bytes.fromhex(t) for t in trained["short"]]
+        long = [bytes.fromhex(t) for t in trained["long"]]
+    else:
+        short, long = _train_tokens(texts)
+        trained.clear()
+        trained.update(text_bytes=size, short=[t.hex() for t in short], long=[t.hex() for t in long])
+    if not shared and not short:
+        return []
+
+    n_short = len(DICT_SHORT_CODES)
+    entries = _stable_slots(short, prev_hashes, n_short)
+    entries += _stable_slots(long, prev_hashes[n_short:], 255)
+    if shared:
+        entries += _stable_slots(sorted(shared), prev_hashes[DICT_TOKEN_SLOTS:], len(shared))
+    while entries and not entries[-1]:
+        entries.pop()
+    codes = {}
+    for i, entry in enumerate(entries):
+        if not entry:
+            continue
+        if i < n_short:
+            codes[entry] = DICT_SHORT_CODES[i : i + 1]
+        elif i < DICT_TOKEN_SLOTS:
+            codes[entry] = bytes((DICT_TOKEN, i - n_short + 1))
+        else:
+            codes[entry] = bytes((DICT_REF, 0x80 | (i >> 7), 0x80 | (i & 0x7F)))
+
+    rx = _token_regex(short + long) if short else None
+    for (c, _), out in zip(blocks, pieces):
+        coded = []
+        for i, piece in enumerate(out):
+            if i % 2:
+                coded.append(codes[piece])
+            elif rx:
+                coded.append(rx.sub(lambda m: codes[m[0]], piece))
+            else:
+                coded.append(piece)
+        c.packed = b"".join(coded)
+    return entries
+
+
+def build_dict_blob(entries: list[bytes]) -> bytes:
+    payload = bytearray()
+    table = bytearray()
+    for data in entries:
+        table += struct.pack(DICT_ENTRY_FMT, len(payload), len(data))
+        payload += data
+    table_off = DICT_HEADER_SIZE
+    payload_off = table_off + len(table)
+    header = struct.pack(
+        DICT_HEADER_FMT, b"NTXD", DICT_VERSION, DICT_HEADER_SIZE, len(entries), table_off, payload_off, len(payload)
+    )
+    blob = header + bytes(table) + bytes(payload)
+    if len(blob) > OS_VAR_MAX_SIZE:
+        raise RuntimeError(f"dictionary blob exceeded OS var max: {len(blob)}")
+    return blob
+
+
+def c_array(name: str, data: bytes) -> str:
+    lines = [f"static const uint8_t {name}[{len(data)}] = {{"]
+    for i in range(0, len(data), 16):
+        lines.append("\t" + ", ".join(f"0x{b:02x}" for b in data[i : i + 16]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def write_embed_source(path: Path, idx_blob: bytes, shards: list[ShardBuild], parts: list[PartBuild]) -> int:
+    total = len(idx_blob) + sum(len(s.payload) for s in shards) + sum(len(p.payload) for p in parts)
+    if total > OS_VAR_MAX_SIZE:
+        raise RuntimeError(f"pack is {total} bytes; too large to compile into the program (max {OS_VAR_MAX_SIZE})")
+
+    out = [
+        "/* Generated by tools/build_pack.py --emit-c; do not edit. */",
+        "",
+        '#include "ntx_embed.h"',
+        "",
+        c_array("s_index", idx_blob),
+    ]
+    for var in shards + parts:
+        out += ["", c_array(f"s_{var.name.lower()}", var.payload)]
+    out += [
+        "",
+        "const NtxEmbedVar ntx_embed_index = { s_index, sizeof(s_index) };",
+        "",
+        "const NtxEmbedVar ntx_embed_shards[] = {",
+    ]
+    out += [f"\t{{ s_{v.name.lower()}, sizeof(s_{v.name.lower()}) }}," for v in shards]
+    out += ["};", "", "const NtxEmbedVar ntx_embed_parts[] = {"]
+    out += [f"\t{{ s_{p.name.lower()}, sizeof(s_{p.name.lower()}) }}," for p in parts]
+    out += ["};", "", f"const uint16_t ntx_embed_part_count = {len(parts)};", ""]
+
+    ensure_dir(path.parent)
+    path.write_text("\n".join(out), encoding="utf-8")
+    return total
+
+
 def ensure_dir(path: Path) -> None:
     path.mkdir(parents=True, exist_ok=True)
 
@@ -345,22 +1187,105 @@ def write_blob(path: Path, data: bytes) -> None:
     path.write_bytes(data)
 
 
-def run_convbin(bin_path: Path, out_path: Path, name: str) -> None:
+def write_cached_blob(cache: BuildCache, path: Path, data: bytes) -> None:
+    digest = content_hash(data)
+    if not cache.fresh(path, digest):
+        write_blob(path, data)
+        cache.record(path, digest)
+
+
+def carry_chunk_heights(notes: list[NoteBuild], prev: dict | None, content_width: int) -> None:
+    """Heights the previous build measured, matched by chunk text, so a build
+    without --format-dry-run keeps them for every chunk that did not change."""
+    if not prev or prev.get("height_width") != content_width:
+        return
+    old: dict[str, int] = {}
+    for n in prev["notes"]:
+        old.update(zip(n["chunk_hashes"], n.get("chunk_heights", [])))
+    for note in notes:
+        for chunk in note.chunks:
+            chunk.height = old.get(content_hash(chunk.data), 0)
+
+
+def apply_chunk_heights(report: dict, notes: list[NoteBuild], warnings: LoudWarningCollector) -> bool:
+    """Takes each chunk's height from the dry run; returns whether any part
+    table changes. texdry also reports the height the viewer's reader found in
+    the pack (carried from the previous build), which must match."""
+    changed = False
+    mismatched: list[str] = []
+    for rec in report["chunks"]:
+        if not rec["ok"]:
+            continue
+        note = notes[rec["note_index"]]
+        chunk = note.chunks[rec["chunk"]]
+        height = min(max(rec["height"], 1), MAX_CHUNK_HEIGHT)
+        stored = rec.get("stored_height", 0)
+        if stored and stored != height:
+            mismatched.append(f"{note.title} chunk {rec['chunk'] + 1} ({stored} -> {height} px)")
+        if chunk.height != height:
+            chunk.height = height
+            changed = True
+    if mismatched:
+        warnings.warn(
+            f"{len(mismatched)} chunk(s) no longer format to the height packed last build (renderer or fonts "
+            f"changed?); updated: {', '.join(mismatched[:3])}"
+        )
+    return changed
+
+
+def build_texdry(root: Path, build_dir: Path) -> Path:
+    subprocess.run(["cmake", "-S", str(root / "host"), "-B", str(build_dir)], check=True)
+    subprocess.run(["cmake", "--build", str(build_dir), "--target", "texdry"], check=True)
+    return build_dir / "texdry"
+
+
+def find_fonts_dir(root: Path) -> Path:
+    for candidate in (root / "assets", root / "external/libtexce/assets"):
+        if (candidate / "TeXFonts.8xv").exists():
+            return candidate
+    raise FileNotFoundError("no TeXFonts.8xv found (expected assets/ or external/libtexce/assets/)")
+
+
+def run_format_dry_run(args: argparse.Namespace, root: Path, out_raw: Path, index_name: str) -> dict:
+    texdry = args.texdry or build_texdry(root, (args.host_build_dir or (root / "build/host")).resolve())
+    fonts_dir = (args.fonts_dir or find_fonts_dir(root)).resolve()
+    report_path = out_raw / "format_report.json"
     cmd = [
-        "convbin",
-        "-j",
-        "bin",
-        "-i",
-        str(bin_path),
-        "-k",
-        "8xv",
-        "-o",
-        str(out_path),
-        "-n",
-        name,
-        "-r",
+        str(texdry),
+        "--vars",
+        f"{out_raw}:{fonts_dir}",
+        "--index",
+        index_name,
+        "--width",
+        str(args.content_width),
+        "--viewport",
+        str(VIEWER_VIEWPORT_HEIGHT),
+        "--slab",
+        str(args.renderer_slab),
+        "--out",
+        str(report_path),
     ]
     subprocess.run(cmd, check=True)
+    report = json.loads(report_path.read_text(encoding="utf-8"))
+    report_path.unlink()
+    return report
+
+
+def check_format_budgets(report: dict, notes: list[NoteBuild], args: argparse.Namespace) -> list[str]:
+    violations: list[str] = []
+    for rec in report["chunks"]:
+        note = notes[rec["note_index"]]
+        where = f"{note.title} chunk {rec['chunk'] + 1}/{len(note.chunks)}"
+        if not rec["ok"]:
+            violations.append(f"{where}: {rec.get('error', 'format failed')}")
+            continue
+        if rec["slab_used"] > args.slab_budget:
+            violations.append(f"{where}: renderer slab {rec['slab_used']} B > budget {args.slab_budget} B")
+        if args.layout_budget and rec["format_peak_bytes"] > args.layout_budget:
+            violations.append(
+                f"{where}: layout heap {rec['format_peak_bytes']} B > budget {args.layout_budget} B"
+            )
+    return violations
 
 
 def discover_note_files(notes_dir: Path) -> list[Path]:
@@ -386,12 +1311,99 @@ def derive_title_from_filename(path: Path) -> str:
     return path.stem
 
 
+def content_hash(data: bytes) -> str:
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def load_previous_build(path: Path | None, prefix: str) -> dict | None:
+    """The manifest of the build being replaced, if it is for the same pack
+    and records ids and hashes; otherwise ids are assigned from scratch."""
+    if path is None or not path.is_file():
+        return None
+    try:
+        prev = json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return None
+    if prev.get("prefix") != prefix or "var_hashes" not in prev:
+        return None
+    return prev
+
+
+def assign_note_ids(notes: list[NoteBuild], prev: dict | None) -> None:
+    """Keeps each surviving note's id; new notes take the lowest free ids."""
+    old = {n["key"]: n["note_id"] for n in prev["notes"]} if prev else {}
+    used = {old[n.key] for n in notes if n.key in old}
+    next_id = 1
+    for note in notes:
+        if note.key in old:
+            note.note_id = old[note.key]
+            continue
+        while next_id in used:
+            next_id += 1
+        note.note_id = next_id
+        used.add(next_id)
+    if max((n.note_id for n in notes), default=0) > MAX_NOTES:
+        raise RuntimeError(f"note ids past {MAX_NOTES}; rebuild without --previous")
+
+
+def assign_part_ranges(notes: list[NoteBuild], prev: dict | None) -> None:
+    """Gives each note a contiguous run of part ids (the viewer reads parts
+    first_part_id..first_part_id+part_count-1). A note that did not grow keeps
+    its run, a grown note extends it in place when the ids are free, and the
+    rest take the first gap that fits, so unchanged notes keep their AppVars."""
+    old = {n["key"]: (n["first_part_id"], n["part_count"]) for n in prev["notes"]} if prev else {}
+    runs: list[tuple[int, int]] = []  # sorted, non-overlapping [start, end)
+
+    def free(start: int, end: int) -> bool:
+        i = bisect.bisect_right(runs, (start, MAX_PART_ID + 2))
+        if i > 0 and runs[i - 1][1] > start:
+            return False
+        return i == len(runs) or runs[i][0] >= end
+
+    def take(note: NoteBuild, start: int) -> None:
+        note.first_part_id = start
+        bisect.insort(runs, (start, start + note.part_count))
+
+    pending: list[NoteBuild] = []
+    for note in notes:
+        first, count = old.get(note.key, (0, 0))
+        if first and note.part_count <= count:
+            take(note, first)
+        else:
+            pending.append(note)
+
+    unplaced: list[NoteBuild] = []
+    for note in pending:
+        first, _ = old.get(note.key, (0, 0))
+        if first and free(first, first + note.part_count):
+            take(note, first)
+        else:
+            unplaced.append(note)
+
+    dense = 0  # runs[:dense] cover ids 1.. without a gap, so the search skips them
+    for note in unplaced:
+        while dense < len(runs) and runs[dense][0] <= (runs[dense - 1][1] if dense else 1):
+            dense += 1
+        start = runs[dense - 1][1] if dense else 1
+        for run_start, run_end in runs[dense:]:
+            if run_start - start >= note.part_count:
+                break
+            start = max(start, run_end)
+        if start + note.part_count - 1 > MAX_PART_ID:
+            raise RuntimeError(f"part ids past {MAX_PART_ID}; split the library into several packs")
+        take(note, start)
+
+
 def build_notes(args: argparse.Namespace) -> int:
     root: Path = args.root.resolve()
     notes_dir = (args.notes_dir or (root / "notes")).resolve()
     out_raw = (args.out_raw or (root / "dist/raw")).resolve()
     out_8xv = (args.out_8xv or (root / "dist/8xv")).resolve()
     latex_cmd_path = (args.latex_commands or (root / "LATEX_COMMANDS_SUPPORTED.md")).resolve()
+    prefix = args.prefix.upper()
+    if not PREFIX_RE.match(prefix):
+        raise ValueError(f"--prefix must be 1-4 letters/digits starting with a letter, got {args.prefix!r}")
+    index_name = f"{prefix}IDX"
 
     ensure_dir(out_raw)
     ensure_dir(out_8xv)
@@ -406,89 +1418,193 @@ def build_notes(args: argparse.Namespace) -> int:
             f"supported-command list exists but no commands were parsed at {latex_cmd_path}; validation skipped"
         )
 
+    timer = StageTimer()
+    cache_path = None if args.no_cache else (args.cache_dir or out_raw.parent / ".cache").resolve() / "build.json"
+    cache = BuildCache(cache_path)
+
     note_files = discover_note_files(notes_dir)
-    notes: list[NoteBuild] = []
+    if len(note_files) > MAX_NOTES:
+        raise RuntimeError(f"{len(note_files)} notes; a pack holds at most {MAX_NOTES}")
+    workers = args.jobs or os.cpu_count() or 1
+
+    with timer.stage("read"):
+        raws = [source.read_bytes() for source in note_files]
+        rels: list[str] = []
+        for source in note_files:
+            try:
+                rels.append(str(source.relative_to(root)))
+            except ValueError:
+                rels.append(str(source))
+
+    with timer.stage("split"):
+        entries: list[dict | None] = []
+        misses: list[tuple[int, str]] = []
+        for i, (raw, rel) in enumerate(zip(raws, rels)):
+            key, entry = cache.lookup(raw, rel, args.target_bytes, args.hard_bytes, not args.no_minify)
+            entries.append(entry)
+            if entry is None:
+                misses.append((i, key))
+        jobs = [(raws[i], rels[i], args.target_bytes, args.hard_bytes, not args.no_minify) for i, _ in misses]
+        for (i, key), entry in zip(misses, split_notes(jobs, workers)):
+            cache.store(key, entry)
+            entries[i] = entry
 
-    for i, source in enumerate(note_files, start=1):
+    notes: list[NoteBuild] = []
+    for i, (source, rel, entry) in enumerate(zip(note_files, rels, entries), start=1):
         title = derive_title_from_filename(source)
         if not title:
             title = source.name
 
-        try:
-            source_rel = str(source.relative_to(root))
-        except ValueError:
-            source_rel = str(source)
-
-        text = source.read_text(encoding="utf-8")
-
-        used_cmds = collect_used_commands(text)
         if supported:
-            unknown = sorted(cmd for cmd in used_cmds if cmd not in supported)
+            unknown = sorted(cmd for cmd in entry["commands"] if cmd not in supported)
             if unknown:
                 warnings.warn(
-                    f"{source_rel}: unsupported commands detected ({', '.join(unknown)})"
+                    f"{rel}: unsupported commands detected ({', '.join(unknown)})"
                 )
-
-        chunks = split_text_deterministic(
-            text=text,
-            target=args.target_bytes,
-            hard=args.hard_bytes,
-            warnings=warnings,
-            source=source_rel,
-        )
+        for msg in entry["warnings"]:
+            warnings.warn(msg)
 
         notes.append(
             NoteBuild(
                 note_id=i,
                 title=title,
                 source=source,
-                chunks=chunks,
+                chunks=[Chunk(text=t, kind=k, idx=c) for c, (t, k) in enumerate(entry["chunks"])],
+                key=source.name,
+                source_bytes=entry["source_bytes"],
             )
         )
 
-    part_builds: list[PartBuild] = []
-    next_part_id = 1
-
-    for note in notes:
-        note_parts = partition_into_parts(note.chunks)
-        note.first_part_id = next_part_id
-        note.part_count = len(note_parts)
-
-        for p_idx, p_chunks in enumerate(note_parts):
-            part_id = next_part_id
-            next_part_id += 1
-            part_name = f"{PART_PREFIX}{part_id:04d}"
-            payload = build_part_blob(
-                note_id=note.note_id,
-                part_index=p_idx,
-                part_count=len(note_parts),
-                chunks=p_chunks,
-            )
-            part_builds.append(
-                PartBuild(
-                    name=part_name,
+    total_chunks = sum(len(n.chunks) for n in notes)
+    if total_chunks > MAX_CHUNKS:
+        raise RuntimeError(f"{total_chunks} chunks; a pack holds at most {MAX_CHUNKS}")
+
+    # A compiled-in pack has no AppVars to keep stable and needs part ids
+    # 1..N without gaps, so it always numbers from scratch.
+    manifest_path = (args.manifest or (root / "dist/pack_manifest.json")).resolve()
+    terminate = args.emit_c is not None
+    prev = None if terminate else load_previous_build(args.previous or manifest_path, prefix)
+    assign_note_ids(notes, prev)
+
+    with timer.stage("parts"):
+        # Compiled-in packs are formatted in place, so their chunks stay whole.
+        dict_entries = []
+        if not terminate and not args.no_dict:
+            dict_entries = build_dictionary(notes, (prev or {}).get("dictionary", []), cache.tokens, warnings)
+        dict_blob = build_dict_blob(dict_entries) if dict_entries else None
+        dict_name = f"{prefix}DIC"
+        note_parts_list = [partition_into_parts(note.chunks, terminate) for note in notes]
+        for note, note_parts in zip(notes, note_parts_list):
+            note.part_count = len(note_parts)
+        assign_part_ranges(notes, prev)
+        carry_chunk_heights(notes, prev, args.content_width)
+
+        part_builds: list[PartBuild] = []
+        for note, note_parts in zip(notes, note_parts_list):
+            for p_idx, p_chunks in enumerate(note_parts):
+                part_id = note.first_part_id + p_idx
+                name = part_var_name(prefix, part_id)
+                payload = build_part_blob(
                     note_id=note.note_id,
                     part_index=p_idx,
                     part_count=len(note_parts),
                     chunks=p_chunks,
-                    payload=payload,
+                    terminate=terminate,
+                )
+                part_builds.append(
+                    PartBuild(
+                        name=name,
+                        note_id=note.note_id,
+                        part_index=p_idx,
+                        part_count=len(note_parts),
+                        chunks=p_chunks,
+                        payload=payload,
+                    )
                 )
-            )
-
-    idx_blob = build_index_blob(notes)
-    idx_raw = out_raw / f"{INDEX_NAME}.bin"
-    write_blob(idx_raw, idx_blob)
-
-    for part in part_builds:
-        write_blob(out_raw / f"{part.name}.bin", part.payload)
 
-    if not args.skip_convbin:
-        run_convbin(idx_raw, out_8xv / f"{INDEX_NAME}.8xv", INDEX_NAME)
-        for part in part_builds:
-            run_convbin(out_raw / f"{part.name}.bin", out_8xv / f"{part.name}.8xv", part.name)
+        max_part_size = max((len(p.payload) for p in part_builds), default=0)
+        shards = build_shards(notes, prefix, args.shard_bytes)
+        idx_blob = build_index_blob(notes, shards, prefix, max_part_size, 0, len(dict_entries))
+
+    with timer.stage("write"):
+        idx_raw = out_raw / f"{index_name}.bin"
+        write_blob(idx_raw, idx_blob)
+        if dict_blob:
+            write_cached_blob(cache, out_raw / f"{dict_name}.bin", dict_blob)
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            outputs = shards + part_builds
+            list(pool.map(lambda v: write_cached_blob(cache, out_raw / f"{v.name}.bin", v.payload), outputs))
+
+    format_report = None
+    if args.format_dry_run:
+        with timer.stage("format_dry_run"):
+            format_report = run_format_dry_run(args, root, out_raw, index_name)
+    format_violations = check_format_budgets(format_report, notes, args) if format_report else []
+    max_layout_bytes = 0
+    if format_report:
+        # The viewer reserves this much at startup so an open never fails for
+        # lack of layout memory; it is the host peak, which overestimates the
+        # CE (3-byte pointers), so no extra margin is added.
+        max_layout_bytes = max((r.get("format_peak_bytes", 0) for r in format_report["chunks"]), default=0)
+        idx_blob = build_index_blob(notes, shards, prefix, max_part_size, max_layout_bytes, len(dict_entries))
+        write_blob(idx_raw, idx_blob)
+        if apply_chunk_heights(format_report, notes, warnings):
+            for part in part_builds:
+                payload = build_part_blob(part.note_id, part.part_index, part.part_count, part.chunks, terminate)
+                if payload != part.payload:
+                    part.payload = payload
+                    write_cached_blob(cache, out_raw / f"{part.name}.bin", payload)
+
+    embed_bytes = 0
+    if args.emit_c and not format_violations:
+        embed_bytes = write_embed_source(args.emit_c.resolve(), idx_blob, shards, part_builds)
+
+    if not args.skip_8xv and not format_violations:
+        with timer.stage("8xv"):
+            write_blob(out_8xv / f"{index_name}.8xv", appvar_bytes(index_name, idx_blob))
+            if dict_blob:
+                write_cached_blob(cache, out_8xv / f"{dict_name}.8xv", appvar_bytes(dict_name, dict_blob))
+            for var in shards + part_builds:
+                x8v = out_8xv / f"{var.name}.8xv"
+                digest = content_hash(var.payload)
+                if not cache.fresh(x8v, digest):
+                    write_blob(x8v, appvar_bytes(var.name, var.payload))
+                    cache.record(x8v, digest)
+    cache.save()
+
+    # Only AppVars whose bytes changed since the previous build go into the
+    # delta group; the root index is always sent so the viewer sees the new
+    # shard table and sizes.
+    # Net of the dictionary AppVar itself.
+    dict_saved = sum(len(c.data) - len(c.stored) for n in notes for c in n.chunks) - len(dict_blob or b"")
+    var_payloads = {index_name: idx_blob}
+    if dict_blob:
+        var_payloads[dict_name] = dict_blob
+    var_payloads.update((v.name, v.payload) for v in shards)
+    var_payloads.update((p.name, p.payload) for p in part_builds)
+    var_hashes = {name: content_hash(data) for name, data in var_payloads.items()}
+    delta = None
+    if prev:
+        old_hashes = prev["var_hashes"]
+        changed = [n for n in var_hashes if n == index_name or old_hashes.get(n) != var_hashes[n]]
+        delta = {
+            "changed": changed,
+            "stale": sorted(n for n in old_hashes if n not in var_hashes),
+            "bytes": sum(len(var_payloads[n]) for n in changed),
+            "full_bytes": sum(len(d) for d in var_payloads.values()),
+        }
+        for name in delta["stale"]:
+            (out_raw / f"{name}.bin").unlink(missing_ok=True)
+            (out_8xv / f"{name}.8xv").unlink(missing_ok=True)
+        if not args.skip_8xv and not format_violations:
+            delta_path = (args.delta_8xg or (root / "dist/NOTES_DELTA.8xg")).resolve()
+            ensure_dir(delta_path.parent)
+            write_blob(delta_path, file_bytes([appvar_entry(n, var_payloads[n]) for n in changed]))
+            delta["group"] = str(delta_path)
 
     build_index = {
-        "index_appvar": INDEX_NAME,
+        "index_appvar": index_name,
+        "prefix": prefix,
         "notes_dir": str(notes_dir),
         "notes": [
             {
@@ -498,20 +1614,84 @@ def build_notes(args: argparse.Namespace) -> int:
                 "part_count": n.part_count,
                 "total_chunks": len(n.chunks),
                 "source": str(n.source),
+                "key": n.key,
+                "source_bytes": n.source_bytes,
+                "text_bytes": sum(len(c.data) for c in n.chunks),
+                "chunk_hashes": [content_hash(c.data) for c in n.chunks],
+                "chunk_heights": [c.height for c in n.chunks],
             }
             for n in notes
         ],
         "part_count": len(part_builds),
+        "shards": [{"appvar": s.name, "first_note": s.first_note, "note_count": s.note_count} for s in shards],
+        "max_chunk_len": max((len(c.data) for n in notes for c in n.chunks), default=0),
+        "max_part_size": max_part_size,
+        "max_layout_bytes": max_layout_bytes,
+        "height_width": args.content_width,
+        "dictionary_appvar": dict_name if dict_blob else None,
+        "dictionary": [content_hash(e) for e in dict_entries],
+        "dictionary_saved_bytes": dict_saved,
+        "var_hashes": var_hashes,
+        "delta": delta,
+        "timings": {"workers": workers, **timer.stages},
         "artifacts": {
             "raw_dir": str(out_raw),
             "x8v_dir": str(out_8xv),
         },
     }
-    (root / "dist/pack_manifest.json").write_text(json.dumps(build_index, indent=2), encoding="utf-8")
-
-    print(f"Built index: {idx_raw}")
-    print(f"Built parts: {len(part_builds)}")
-    if not args.skip_convbin:
+    if format_report:
+        for n_idx, entry in enumerate(build_index["notes"]):
+            entry["chunks"] = [
+                {k: v for k, v in rec.items() if k not in ("note_index", "note_id")}
+                for rec in format_report["chunks"]
+                if rec["note_index"] == n_idx
+            ]
+        build_index["format_dry_run"] = {
+            "content_width": format_report["width"],
+            "viewport": format_report["viewport"],
+            "renderer_slab": format_report["slab_size"],
+            "slab_budget": args.slab_budget,
+            "layout_budget": args.layout_budget,
+            "cycle_model": format_report["cycle_model"],
+            "violations": format_violations,
+        }
+    ensure_dir(manifest_path.parent)
+    manifest_path.write_text(json.dumps(build_index, indent=2), encoding="utf-8")
+
+    if format_violations:
+        for v in format_violations:
+            print(f"over budget: {v}", file=sys.stderr)
+        raise RuntimeError(f"{len(format_violations)} chunk(s) exceed the format budget; see {manifest_path}")
+
+    print(f"Built index: {idx_raw} ({len(shards)} shard(s))")
+    print(f"Built parts: {len(part_builds)} ({cache.hits} of {len(notes)} notes reused from cache)")
+    if dict_blob:
+        tokens = sum(1 for e in dict_entries[:DICT_TOKEN_SLOTS] if e)
+        print(
+            f"Dictionary: {dict_name}, {tokens} tokens and {len(dict_entries[DICT_TOKEN_SLOTS:])} shared blocks, "
+            f"{dict_saved} of {sum(len(c.data) for n in notes for c in n.chunks)} text bytes saved"
+        )
+    source_bytes = sum(n.source_bytes for n in notes)
+    text_bytes = sum(len(c.data) for n in notes for c in n.chunks)
+    if source_bytes != text_bytes:
+        reduced = sorted(notes, key=lambda n: sum(len(c.data) for c in n.chunks) - n.source_bytes)[:3]
+        print(
+            f"Preprocessed notes: {source_bytes} -> {text_bytes} bytes; most reduced: "
+            + ", ".join(f"{n.key} {sum(len(c.data) for c in n.chunks) - n.source_bytes:+d}" for n in reduced)
+        )
+    print(f"Stage timings (--jobs {workers}): {timer.summary()}")
+    if delta:
+        print(
+            f"Changed since previous build: {len(delta['changed'])} of {len(var_hashes)} AppVars, "
+            f"{delta['bytes']} of {delta['full_bytes']} bytes"
+        )
+        if "group" in delta:
+            print(f"Delta group: {delta['group']}")
+        if delta["stale"]:
+            print(f"No longer used (safe to delete on the calculator): {', '.join(delta['stale'])}")
+    if args.emit_c:
+        print(f"Wrote compiled-in pack: {args.emit_c} ({embed_bytes} bytes)")
+    if not args.skip_8xv:
         print(f"Generated AppVars in: {out_8xv}")
 
     warnings.emit()
@@ -523,7 +1703,7 @@ def main() -> int:
     try:
         return build_notes(args)
     except subprocess.CalledProcessError as e:
-        print(f"convbin failed: {e}", file=sys.stderr)
+        print(f"command failed: {e}", file=sys.stderr)
         return 2
     except Exception as e:
         print(f"build failed: {e}", file=sys.stderr)
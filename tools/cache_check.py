@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Check that build_pack.py's output cache never leaves stale files behind.
+
+Builds the notes once from scratch as a reference. Then, in a second output
+tree, it runs a cached build, a --no-cache build with different options
+(--no-dict) and a cached build again. The last build must leave exactly the
+reference bytes in raw/ and 8xv/, and every manifest var_hash must match the
+file on disk. Needs only Python 3.
+
+    python3 tools/cache_check.py
+    python3 tools/cache_check.py --notes-dir path/to/notes
+"""
+from __future__ import annotations
+
+import argparse
+import hashlib
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Check cached builds against a clean one")
+    p.add_argument("--notes-dir", type=Path, default=ROOT / "notes")
+    return p.parse_args()
+
+
+def build(notes_dir: Path, out: Path, *extra: str) -> None:
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/build_pack.py"),
+        "--notes-dir",
+        str(notes_dir),
+        "--out-raw",
+        str(out / "raw"),
+        "--out-8xv",
+        str(out / "8xv"),
+        "--manifest",
+        str(out / "pack_manifest.json"),
+        "--delta-8xg",
+        str(out / "NOTES_DELTA.8xg"),
+        *extra,
+    ]
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def tree_bytes(out: Path) -> dict[str, bytes]:
+    return {str(p.relative_to(out)): p.read_bytes() for d in ("raw", "8xv") for p in sorted((out / d).glob("*.*"))}
+
+
+def main() -> int:
+    args = parse_args()
+    problems: list[str] = []
+    with tempfile.TemporaryDirectory(prefix="cache_check_") as tmp:
+        ref, out = Path(tmp) / "ref", Path(tmp) / "out"
+        try:
+            build(args.notes_dir, ref, "--no-cache")
+            build(args.notes_dir, out)
+            build(args.notes_dir, out, "--no-cache", "--no-dict")
+            build(args.notes_dir, out)
+        except subprocess.CalledProcessError as e:
+            print(f"cache_check: build failed: {e}", file=sys.stderr)
+            return 1
+
+        want, got = tree_bytes(ref), tree_bytes(out)
+        for name in sorted(want.keys() | got.keys()):
+            if want.get(name) != got.get(name):
+                problems.append(f"{name}: differs from a clean build")
+        manifest = json.loads((out / "pack_manifest.json").read_text(encoding="utf-8"))
+        for name, digest in manifest["var_hashes"].items():
+            path = out / "raw" / f"{name}.bin"
+            on_disk = hashlib.sha256(path.read_bytes()).hexdigest()[:16] if path.is_file() else "missing"
+            if on_disk != digest:
+                problems.append(f"{name}: manifest hash {digest}, file {on_disk}")
+
+    for p in problems:
+        print(p)
+    print(f"cache_check: {len(want)} outputs, {len(problems)} problem(s)")
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
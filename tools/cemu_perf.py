@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+"""Emulator performance suite for the instrumented viewer (-DNTX_PERF=ON).
+
+  scenario  write a CEmu autotester config: launch, open chunk N, scroll to the
+            bottom, return, open the next chunk, ..., exit
+  run       write the config, run CEmu's autotester and extract the results
+  extract   decode NTXPERF (autotester log, NTXPERF.8xv or raw .bin) to JSON
+
+    python3 tools/cemu_perf.py run --rom 84pce.rom --files build/ce/bin/NOTES.8xp \\
+        dist/8xv/*.8xv assets/*.8xv clibs.8xg --chunks 0,1,2 --out build/perf.json
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import re
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+# Order must match NtxPerfPhase in viewer/include/ntx_perf.h.
+PHASES = (
+    "index_load",
+    "menu_build",
+    "menu_frame",
+    "open",
+    "chunk_load",
+    "format",
+    "frame",
+    "tex_draw",
+    "swap",
+)
+
+PERF_HEADER_FMT = "<4sHHIBBHH"
+PERF_PHASE_FMT = "<IIIII16H"
+PERF_EVENT_FMT = "<BBHI"
+PERF_HEADER_SIZE = struct.calcsize(PERF_HEADER_FMT)
+PERF_PHASE_SIZE = struct.calcsize(PERF_PHASE_FMT)
+PERF_EVENT_SIZE = struct.calcsize(PERF_EVENT_FMT)
+HIST_BASE_CYCLES = 1024
+
+# Must match viewer/src/main.c: viewport height and scroll step.
+VIEWER_VIEWPORT_HEIGHT = 240 - 12 - 10
+VIEWER_SCROLL_STEP = 10
+
+X8V_DATA_OFFSET = 74
+CONSOLE_RE = re.compile(r"NTXPERF ([0-9a-f]{4}) ([0-9a-f]+)")
+CONSOLE_END_RE = re.compile(r"NTXPERF end (\d+)")
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="CEmu-driven viewer performance suite")
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    def scenario_args(sp: argparse.ArgumentParser) -> None:
+        sp.add_argument("--rom", type=Path, required=True, help="TI-84 Plus CE ROM image")
+        sp.add_argument("--files", type=Path, nargs="+", required=True, help=".8xp/.8xv/.8xg files to transfer")
+        sp.add_argument("--program", default="NOTES")
+        sp.add_argument("--chunks", default="0,1", help="menu indices to open, in order")
+        sp.add_argument("--manifest", type=Path, help="pack_manifest.json with --format-dry-run heights")
+        sp.add_argument("--scroll-steps", type=int, default=40, help="down presses per chunk without heights")
+        sp.add_argument("--key-delay", type=int, default=120, help="ms after each key press")
+        sp.add_argument("--settle", type=int, default=1500, help="ms after launch and after opening a chunk")
+        sp.add_argument("--config", type=Path, default=Path("build/cemu/perf_scenario.json"))
+
+    sc = sub.add_parser("scenario", help="write the autotester config")
+    scenario_args(sc)
+
+    run = sub.add_parser("run", help="write the config, run the autotester and extract")
+    scenario_args(run)
+    run.add_argument("--autotester", default="autotester", help="CEmu autotester binary")
+    run.add_argument("--log", type=Path, default=Path("build/cemu/autotester.log"))
+    run.add_argument("--out", type=Path, default=Path("build/cemu/perf.json"))
+
+    ex = sub.add_parser("extract", help="decode NTXPERF results to JSON")
+    src = ex.add_mutually_exclusive_group(required=True)
+    src.add_argument("--log", type=Path, help="autotester / CEmu console log")
+    src.add_argument("--var", type=Path, help="NTXPERF.8xv or NTXPERF.bin")
+    ex.add_argument("--out", type=Path, help="output JSON (default: stdout)")
+    return p.parse_args()
+
+
+def chunk_heights(manifest_path: Path | None) -> list[int | None]:
+    if not manifest_path:
+        return []
+    manifest = json.loads(manifest_path.read_text(encoding="utf-8"))
+    heights: list[int | None] = []
+    for note in manifest["notes"]:
+        recs = note.get("chunks")
+        if recs is None:
+            heights.extend([None] * note["total_chunks"])
+        else:
+            heights.extend(r.get("height") if r.get("ok") else None for r in recs)
+    return heights
+
+
+def scroll_steps_for(height: int | None, default: int) -> int:
+    if height is None:
+        return default
+    return math.ceil(max(0, height - VIEWER_VIEWPORT_HEIGHT) / VIEWER_SCROLL_STEP) + 1
+
+
+def build_scenario(args: argparse.Namespace) -> dict:
+    chunks = [int(c) for c in args.chunks.split(",") if c.strip()]
+    heights = chunk_heights(args.manifest)
+
+    def key(name: str) -> list[str]:
+        return [f"key|{name}", f"delay|{args.key_delay}"]
+
+    seq: list[str] = ["action|launch", f"delay|{args.settle}"]
+    sel = 0
+    for target in chunks:
+        while sel < target:
+            seq += key("down")
+            sel += 1
+        while sel > target:
+            seq += key("up")
+            sel -= 1
+        seq += key("enter")
+        seq.append(f"delay|{args.settle}")
+        height = heights[target] if target < len(heights) else None
+        for _ in range(scroll_steps_for(height, args.scroll_steps)):
+            seq += key("down")
+        seq += key("clear")
+        seq.append(f"delay|{args.settle}")
+    seq += key("clear")
+    seq.append("delay|3000")
+
+    return {
+        "rom": str(args.rom.resolve()),
+        "transfer_files": [str(f.resolve()) for f in args.files],
+        "target": {"name": args.program, "isASM": True},
+        "sequence": seq,
+    }
+
+
+def write_scenario(args: argparse.Namespace) -> Path:
+    config = build_scenario(args)
+    args.config.parent.mkdir(parents=True, exist_ok=True)
+    args.config.write_text(json.dumps(config, indent=2), encoding="utf-8")
+    return args.config
+
+
+def blob_from_console(text: str) -> bytes:
+    """Reassembles the last complete NTXPERF dump in a console log."""
+    blob = bytearray()
+    result: bytes | None = None
+    for line in text.splitlines():
+        m = CONSOLE_RE.search(line)
+        if m:
+            off = int(m.group(1), 16)
+            if off == 0:
+                blob = bytearray()
+            if off != len(blob):
+                raise ValueError(f"NTXPERF dump out of order at offset {off:#x}")
+            blob.extend(bytes.fromhex(m.group(2)))
+            continue
+        m = CONSOLE_END_RE.search(line)
+        if m:
+            if int(m.group(1)) != len(blob):
+                raise ValueError("NTXPERF dump truncated")
+            result = bytes(blob)
+    if result is None:
+        raise ValueError("no complete NTXPERF dump found in log")
+    return result
+
+
+def blob_from_var(path: Path) -> bytes:
+    data = path.read_bytes()
+    if path.suffix.lower() == ".8xv":
+        size = struct.unpack_from("<H", data, X8V_DATA_OFFSET - 2)[0]
+        return data[X8V_DATA_OFFSET : X8V_DATA_OFFSET + size]
+    return data
+
+
+def hist_percentile(hist: tuple[int, ...], q: float, max_cycles: int) -> int:
+    """Upper bound of the histogram bucket holding quantile q."""
+    total = sum(hist)
+    if total == 0:
+        return 0
+    rank = q * total
+    seen = 0
+    for b, n in enumerate(hist):
+        seen += n
+        if seen >= rank:
+            return min(HIST_BASE_CYCLES << b, max_cycles) if b < len(hist) - 1 else max_cycles
+    return max_cycles
+
+
+def decode(blob: bytes) -> dict:
+    magic, version, hdr_size, clock_hz, phase_count, buckets, event_count, dropped = struct.unpack_from(
+        PERF_HEADER_FMT, blob, 0
+    )
+    if magic != b"NTXF" or version != 1 or hdr_size != PERF_HEADER_SIZE or buckets != 16:
+        raise ValueError("not an NTXPERF v1 blob")
+    expected = hdr_size + phase_count * PERF_PHASE_SIZE + event_count * PERF_EVENT_SIZE
+    if len(blob) < expected:
+        raise ValueError(f"NTXPERF blob truncated ({len(blob)} < {expected})")
+
+    def ms(cycles: float) -> float:
+        return round(cycles * 1000.0 / clock_hz, 3)
+
+    phases: dict[str, dict] = {}
+    pos = hdr_size
+    for i in range(phase_count):
+        count, cmin, cmax, tot_lo, tot_hi, *hist = struct.unpack_from(PERF_PHASE_FMT, blob, pos)
+        pos += PERF_PHASE_SIZE
+        total = tot_lo | (tot_hi << 32)
+        name = PHASES[i] if i < len(PHASES) else f"phase{i}"
+        mean = total / count if count else 0
+        p50 = hist_percentile(tuple(hist), 0.5, cmax)
+        p90 = hist_percentile(tuple(hist), 0.9, cmax)
+        phases[name] = {
+            "count": count,
+            "min_cycles": cmin,
+            "max_cycles": cmax,
+            "mean_cycles": round(mean),
+            "total_cycles": total,
+            "p50_le_cycles": p50,
+            "p90_le_cycles": p90,
+            "mean_ms": ms(mean),
+            "max_ms": ms(cmax),
+            "p90_le_ms": ms(p90),
+        }
+
+    events: list[dict] = []
+    opens: dict[int, dict] = {}
+    for _ in range(event_count):
+        phase, _reserved, tag, cycles = struct.unpack_from(PERF_EVENT_FMT, blob, pos)
+        pos += PERF_EVENT_SIZE
+        name = PHASES[phase] if phase < len(PHASES) else f"phase{phase}"
+        events.append({"phase": name, "tag": tag, "cycles": cycles, "ms": ms(cycles)})
+        if name in ("open", "chunk_load", "format"):
+            opens.setdefault(tag, {"menu_index": tag})[f"{name}_ms"] = ms(cycles)
+
+    return {
+        "clock_hz": clock_hz,
+        "events_dropped": dropped,
+        "phases": phases,
+        "opens": [opens[t] for t in sorted(opens)],
+        "events": events,
+    }
+
+
+def write_json(data: dict, out: Path | None) -> None:
+    text = json.dumps(data, indent=2)
+    if out is None:
+        print(text)
+        return
+    out.parent.mkdir(parents=True, exist_ok=True)
+    out.write_text(text, encoding="utf-8")
+    print(f"Wrote {out}")
+
+
+def main() -> int:
+    args = parse_args()
+    try:
+        if args.cmd == "scenario":
+            print(f"Wrote {write_scenario(args)}")
+            return 0
+        if args.cmd == "run":
+            config = write_scenario(args)
+            args.log.parent.mkdir(parents=True, exist_ok=True)
+            proc = subprocess.run([args.autotester, str(config)], capture_output=True, text=True)
+            args.log.write_text(proc.stdout + proc.stderr, encoding="utf-8")
+            write_json(decode(blob_from_console(proc.stdout + proc.stderr)), args.out)
+            return 0
+        blob = blob_from_console(args.log.read_text(encoding="utf-8")) if args.log else blob_from_var(args.var)
+        write_json(decode(blob), args.out)
+        return 0
+    except (OSError, ValueError, struct.error) as e:
+        print(f"cemu_perf: {e}", file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
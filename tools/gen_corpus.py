@@ -0,0 +1,343 @@
+#!/usr/bin/env python3
+"""Generate synthetic note libraries and run them through build_pack.py.
+
+Corpora are deterministic for a given seed. With --build every corpus is
+packed (.8xv output skipped) and a scaling report is printed: build time, part
+and chunk counts, index size, and headroom against the limits the viewer
+and pack format impose today. --split-mb times the note splitter alone on
+single notes of the given sizes, to check that it scales linearly.
+
+    python3 tools/gen_corpus.py --notes 100,500,2000 --build
+    python3 tools/gen_corpus.py --split-mb 1,2,4,8
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import random
+import shutil
+import subprocess
+import sys
+import time
+from dataclasses import asdict, dataclass
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+
+# Limits the generated packs are measured against.
+OS_VAR_MAX_SIZE = 65512
+MAX_PART_ID = 0xFFFF  # u16 in the index entry, four base-36 digits in the name
+MAX_CHUNKS = 0xFFFFFFFF  # u32 chunk numbers in the index and the viewer menu
+
+WORDS = (
+    "charge field potential energy flux surface integral point distance radius sphere shell "
+    "cylinder plate conductor insulator density uniform symmetric component direction vector "
+    "magnitude origin axis angle force particle velocity mass equilibrium gradient constant "
+    "total element region boundary inside outside between along perpendicular parallel result "
+    "therefore substitute simplify evaluate assume given find consider small large"
+).split()
+
+GREEK = ("alpha", "beta", "gamma", "theta", "lambda", "mu", "rho", "sigma", "phi", "omega", "epsilon")
+FUNCS = ("sin", "cos", "tan", "ln", "exp", "log")
+UTF8_SYMBOLS = ("→", "×", "·", "≤", "≥", "≈", "±", "°", "α", "β", "θ", "λ", "μ", "π", "σ", "Ω", "∞", "∫", "√", "’")
+RULE = "-" * 60
+
+SIZE_DISTS = ("fixed", "uniform", "lognormal", "pareto")
+
+
+@dataclass
+class CorpusSpec:
+    notes: int
+    seed: int
+    size_dist: str
+    mean_bytes: int
+    max_bytes: int
+    math_density: float
+    long_title_ratio: float
+    utf8_ratio: float
+
+
+@dataclass
+class CorpusReport:
+    notes: int
+    source_bytes: int
+    build_seconds: float
+    ok: bool
+    error: str = ""
+    parts: int = 0
+    chunks: int = 0
+    max_chunks_per_note: int = 0
+    index_bytes: int = 0
+    shards: int = 0
+    max_shard_bytes: int = 0
+    max_part_bytes: int = 0
+    max_part_id: int = 0
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Generate synthetic note corpora for scaling tests")
+    p.add_argument("--out", type=Path, default=ROOT / "build/corpus", help="output root (one subdir per corpus)")
+    p.add_argument("--notes", default="200", help="note count, or comma-separated counts for a sweep")
+    p.add_argument("--seed", type=int, default=1)
+    p.add_argument("--size-dist", choices=SIZE_DISTS, default="lognormal")
+    p.add_argument("--mean-bytes", type=int, default=3000, help="mean note size in bytes")
+    p.add_argument("--max-bytes", type=int, default=400000, help="cap on a single note's size")
+    p.add_argument("--math-density", type=float, default=0.3, help="0..1, share of sentences carrying math")
+    p.add_argument("--long-titles", type=float, default=0.05, help="0..1, share of notes with long titles")
+    p.add_argument("--utf8", type=float, default=0.02, help="0..1, share of sentences with raw UTF-8 symbols")
+    p.add_argument("--build", action="store_true", help="pack each corpus with tools/build_pack.py")
+    p.add_argument("--report", type=Path, help="write the scaling report as JSON")
+    p.add_argument("--keep-going", action="store_true", help="continue the sweep after a failed build")
+    p.add_argument("--split-mb", help="comma-separated note sizes in MB: time build_pack's splitter on each")
+    return p.parse_args()
+
+
+def note_size(rng: random.Random, spec: CorpusSpec) -> int:
+    if spec.size_dist == "fixed":
+        size = spec.mean_bytes
+    elif spec.size_dist == "uniform":
+        size = rng.randint(1, 2 * spec.mean_bytes)
+    elif spec.size_dist == "lognormal":
+        sigma = 1.0
+        size = int(rng.lognormvariate(math.log(spec.mean_bytes) - (sigma * sigma) / 2.0, sigma))
+    else:
+        alpha = 1.5
+        size = int(spec.mean_bytes * (alpha - 1.0) / alpha * rng.paretovariate(alpha))
+    return max(64, min(size, spec.max_bytes))
+
+
+def inline_math(rng: random.Random) -> str:
+    a, b = rng.choice(GREEK), rng.choice(GREEK)
+    forms = (
+        f"\\{a}=\\frac{{{rng.randint(1, 9)}}}{{{rng.randint(2, 9)}}}\\{b}",
+        f"\\{rng.choice(FUNCS)}\\left(\\{a}\\right)",
+        f"x^{{{rng.randint(2, 5)}}}+\\sqrt{{\\{b}}}",
+        f"E_{{{rng.choice('xyz')}}}\\approx {rng.randint(1, 99)}\\,\\text{{N/C}}",
+    )
+    return "$" + rng.choice(forms) + "$"
+
+
+def display_math(rng: random.Random) -> str:
+    a = rng.choice(GREEK)
+    forms = (
+        f"\\vec{{E}}=\\frac{{1}}{{4\\pi\\epsilon_0}}\\int \\frac{{dq}}{{r^2}}\\hat{{r}}",
+        f"\\oint \\vec{{E}}\\cdot d\\vec{{A}}=\\frac{{Q_{{enc}}}}{{\\epsilon_0}}",
+        f"V=\\int_{{0}}^{{R}} \\frac{{\\{a}\\,dr}}{{\\sqrt{{r^2+a^2}}}}",
+        f"\\sum_{{i=1}}^{{{rng.randint(2, 9)}}} \\{a}_i^2 \\le \\left(\\sum_{{i}} \\{a}_i\\right)^2",
+    )
+    return "$$" + rng.choice(forms) + "$$"
+
+
+def sentence(rng: random.Random, spec: CorpusSpec) -> str:
+    words = [rng.choice(WORDS) for _ in range(rng.randint(5, 16))]
+    words[0] = words[0].capitalize()
+    if rng.random() < spec.math_density:
+        words.insert(rng.randint(1, len(words)), inline_math(rng))
+    if rng.random() < spec.utf8_ratio:
+        words.insert(rng.randint(1, len(words)), rng.choice(UTF8_SYMBOLS))
+    return " ".join(words) + rng.choice(".....?!")
+
+
+def note_body(rng: random.Random, spec: CorpusSpec, title: str, size: int) -> str:
+    out: list[str] = [title, ""]
+    total = len(title) + 1
+    step = 1
+    while total < size:
+        if rng.random() < 0.15:
+            block = f"{RULE}\nSTEP {step} — {rng.choice(WORDS)} {rng.choice(WORDS)}\n"
+            step += 1
+        elif rng.random() < spec.math_density * 0.5:
+            block = display_math(rng) + "\n"
+        else:
+            block = " ".join(sentence(rng, spec) for _ in range(rng.randint(2, 6))) + "\n"
+        out.append(block)
+        total += len(block.encode("utf-8")) + 1
+    return "\n".join(out)
+
+
+def note_title(rng: random.Random, spec: CorpusSpec, i: int) -> str:
+    words = [rng.choice(WORDS).capitalize() for _ in range(rng.randint(1, 3))]
+    if rng.random() < spec.long_title_ratio:
+        # Long enough to hit the 255-byte title cap but within common filename limits.
+        words = [rng.choice(WORDS).capitalize() for _ in range(40)]
+    if rng.random() < spec.utf8_ratio:
+        words.append(rng.choice(UTF8_SYMBOLS[8:]))
+    stem = f"{i:05d}_" + "_".join(words)
+    while len(stem.encode("utf-8")) > 240:
+        stem = stem[:-1]
+    return stem
+
+
+def generate_corpus(spec: CorpusSpec, out_dir: Path) -> int:
+    """Writes spec.notes files into out_dir (spec.json beside it) and returns
+    the total byte count."""
+    if out_dir.exists():
+        shutil.rmtree(out_dir)
+    out_dir.mkdir(parents=True)
+    rng = random.Random(f"{spec.seed}:{spec.notes}")
+    total = 0
+    for i in range(spec.notes):
+        title = note_title(rng, spec, i)
+        data = note_body(rng, spec, title, note_size(rng, spec)).encode("utf-8")
+        (out_dir / f"{title}.tex").write_bytes(data)
+        total += len(data)
+    (out_dir.parent / "spec.json").write_text(json.dumps(asdict(spec), indent=2), encoding="utf-8")
+    return total
+
+
+def build_and_measure(notes_dir: Path, pack_dir: Path, report: CorpusReport) -> None:
+    raw = pack_dir / "raw"
+    manifest_path = pack_dir / "pack_manifest.json"
+    if pack_dir.exists():
+        shutil.rmtree(pack_dir)
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/build_pack.py"),
+        "--notes-dir",
+        str(notes_dir),
+        "--out-raw",
+        str(raw),
+        "--out-8xv",
+        str(pack_dir / "8xv"),
+        "--manifest",
+        str(manifest_path),
+        "--skip-8xv",
+    ]
+    t0 = time.perf_counter()
+    proc = subprocess.run(cmd, capture_output=True, text=True)
+    report.build_seconds = round(time.perf_counter() - t0, 3)
+    if proc.returncode != 0:
+        report.ok = False
+        lines = [l for l in proc.stderr.splitlines() if l.strip()]
+        report.error = lines[-1] if lines else f"build_pack exited {proc.returncode}"
+        return
+
+    manifest = json.loads(manifest_path.read_text(encoding="utf-8"))
+    report.parts = manifest["part_count"]
+    report.chunks = sum(n["total_chunks"] for n in manifest["notes"])
+    report.max_chunks_per_note = max((n["total_chunks"] for n in manifest["notes"]), default=0)
+    report.max_part_id = max((n["first_part_id"] + n["part_count"] - 1 for n in manifest["notes"]), default=0)
+    report.index_bytes = (raw / f"{manifest['index_appvar']}.bin").stat().st_size
+    shard_names = {s["appvar"] for s in manifest["shards"]}
+    report.shards = len(shard_names)
+    report.max_shard_bytes = max(((raw / f"{n}.bin").stat().st_size for n in shard_names), default=0)
+    report.max_part_bytes = max(
+        (
+            p.stat().st_size
+            for p in raw.glob("*.bin")
+            if p.stem not in (manifest["index_appvar"], manifest.get("dictionary_appvar")) and p.stem not in shard_names
+        ),
+        default=0,
+    )
+
+
+def headroom(value: int, limit: int) -> str:
+    return f"{value * 100.0 / limit:5.1f}%"
+
+
+def print_report(rows: list[CorpusReport]) -> None:
+    print(
+        f"{'notes':>7} {'src KB':>9} {'build s':>8} {'parts':>6} {'chunks':>7} {'index B':>8} "
+        f"{'idx/64K':>7} {'shards':>6} {'shard B':>7} {'part ids':>8} {'max part B':>10}"
+    )
+    for r in rows:
+        if not r.ok:
+            print(f"{r.notes:>7} {r.source_bytes / 1024:>9.1f} {r.build_seconds:>8.2f}  FAILED: {r.error}")
+            continue
+        print(
+            f"{r.notes:>7} {r.source_bytes / 1024:>9.1f} {r.build_seconds:>8.2f} {r.parts:>6} {r.chunks:>7} "
+            f"{r.index_bytes:>8} {headroom(r.index_bytes, OS_VAR_MAX_SIZE):>7} {r.shards:>6} {r.max_shard_bytes:>7} "
+            f"{headroom(r.max_part_id, MAX_PART_ID):>8} {r.max_part_bytes:>10}"
+        )
+    print(
+        f"limits: index AppVar {OS_VAR_MAX_SIZE} B, part ids NTX0001..NTX1EKF ({MAX_PART_ID}), "
+        f"{MAX_CHUNKS} chunks; build_pack.py rejects a library past any of them"
+    )
+
+
+def split_sweep(spec: CorpusSpec, sizes_mb: list[float]) -> None:
+    """Times boundary detection and splitting on one prose note and one note
+    of display math on single lines (few break points) per size."""
+    from build_pack import LoudWarningCollector, compute_boundaries, split_text_deterministic
+
+    print(f"{'shape':>6} {'MB':>6} {'bounds s':>9} {'split s':>8} {'chunks':>7} {'us/KB':>7}")
+    for shape in ("prose", "sparse"):
+        for mb in sizes_mb:
+            size = int(mb * 1024 * 1024)
+            rng = random.Random(f"{spec.seed}:split:{shape}")
+            if shape == "prose":
+                text = note_body(rng, spec, "Split sweep", size)
+            else:
+                blocks: list[str] = []
+                total = 0
+                while total < size:
+                    blocks.append(display_math(rng))
+                    total += len(blocks[-1]) + 1
+                text = "\n".join(blocks)
+            bounds_s = split_s = math.inf
+            for _ in range(3):  # best of three, to keep GC and scheduler noise out
+                t0 = time.perf_counter()
+                compute_boundaries(text)
+                t1 = time.perf_counter()
+                # build_pack.py's default --target-bytes/--hard-bytes.
+                chunks = split_text_deterministic(text, 40960, 49152, LoudWarningCollector(), shape)
+                t2 = time.perf_counter()
+                bounds_s, split_s = min(bounds_s, t1 - t0), min(split_s, t2 - t1)
+            print(
+                f"{shape:>6} {mb:>6g} {bounds_s:>9.3f} {split_s:>8.3f} {len(chunks):>7} "
+                f"{split_s * 1e6 / (len(text) / 1024):>7.2f}"
+            )
+
+
+def main() -> int:
+    args = parse_args()
+    if args.split_mb:
+        spec = CorpusSpec(1, args.seed, "fixed", 0, 0, args.math_density, 0.0, args.utf8)
+        split_sweep(spec, [float(m) for m in args.split_mb.split(",") if m.strip()])
+        return 0
+    try:
+        counts = [int(c) for c in args.notes.split(",") if c.strip()]
+    except ValueError:
+        print(f"invalid --notes: {args.notes}", file=sys.stderr)
+        return 2
+    if not counts or min(counts) <= 0:
+        print("--notes needs positive counts", file=sys.stderr)
+        return 2
+
+    out_root: Path = args.out.resolve()
+    rows: list[CorpusReport] = []
+    for count in counts:
+        spec = CorpusSpec(
+            notes=count,
+            seed=args.seed,
+            size_dist=args.size_dist,
+            mean_bytes=args.mean_bytes,
+            max_bytes=args.max_bytes,
+            math_density=args.math_density,
+            long_title_ratio=args.long_titles,
+            utf8_ratio=args.utf8,
+        )
+        corpus_dir = out_root / f"n{count}"
+        notes_dir = corpus_dir / "notes"
+        source_bytes = generate_corpus(spec, notes_dir)
+        print(f"Generated {count} notes ({source_bytes / 1024:.1f} KB) in {notes_dir}")
+        if not args.build:
+            continue
+
+        row = CorpusReport(notes=count, source_bytes=source_bytes, build_seconds=0.0, ok=True)
+        build_and_measure(notes_dir, corpus_dir / "pack", row)
+        rows.append(row)
+        if not row.ok and not args.keep_going:
+            break
+
+    if rows:
+        print_report(rows)
+        if args.report:
+            args.report.parent.mkdir(parents=True, exist_ok=True)
+            args.report.write_text(json.dumps([asdict(r) for r in rows], indent=2), encoding="utf-8")
+    return 0 if all(r.ok for r in rows) else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""Decode the viewer's NTXTRACE AppVar into a timeline and summary stats.
+
+    python3 tools/ntxtrace.py NTXTRACE.8xv --manifest dist/pack_manifest.json
+    python3 tools/ntxtrace.py NTXTRACE.bin --json trace.json
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import struct
+import sys
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from statistics import median
+
+# Must match viewer/src/ntx_trace.c.
+TRACE_HEADER_FMT = "<4sHHIHHI"
+TRACE_RECORD_FMT = "<IHBBHH"
+TRACE_HEADER_SIZE = struct.calcsize(TRACE_HEADER_FMT)
+TRACE_RECORD_SIZE = struct.calcsize(TRACE_RECORD_FMT)
+X8V_DATA_OFFSET = 74
+
+# Must match NtxTraceEvent / NtxOomSite in viewer/include/ntx_trace.h.
+EVENTS = {
+    1: "session",
+    2: "index_load",
+    3: "open",
+    4: "close",
+    5: "part_read",
+    6: "format_begin",
+    7: "format_end",
+    8: "draw",
+    9: "cache_hit",
+    10: "cache_miss",
+    11: "oom",
+    12: "load_fail",
+    13: "heap",
+    14: "shard_load",
+    15: "dict_read",
+}
+OOM_SITES = {
+    1: "appvar buffer",
+    2: "index entries",
+    3: "note title",
+    4: "chunk text",
+    5: "chunk menu",
+    6: "layout (tex_format)",
+    7: "renderer slab",
+}
+
+
+@dataclass
+class TraceEvent:
+    t_ms: float
+    dur_ms: float
+    kind: str
+    a: int
+    b: int
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Decode an NTXTRACE AppVar")
+    p.add_argument("trace", type=Path, help="NTXTRACE.8xv or NTXTRACE.bin")
+    p.add_argument("--manifest", type=Path, help="pack_manifest.json, to print note titles")
+    p.add_argument("--json", type=Path, help="write events and summary as JSON")
+    p.add_argument("--no-timeline", action="store_true", help="print only the summary")
+    return p.parse_args()
+
+
+def load_blob(path: Path) -> bytes:
+    data = path.read_bytes()
+    if path.suffix.lower() == ".8xv":
+        size = struct.unpack_from("<H", data, X8V_DATA_OFFSET - 2)[0]
+        return data[X8V_DATA_OFFSET : X8V_DATA_OFFSET + size]
+    return data
+
+
+def decode(blob: bytes) -> tuple[dict, list[TraceEvent]]:
+    magic, version, hdr_size, tick_hz, count, capacity, total = struct.unpack_from(TRACE_HEADER_FMT, blob, 0)
+    if magic != b"NTXT" or version != 1 or hdr_size != TRACE_HEADER_SIZE:
+        raise ValueError("not an NTXTRACE v1 blob")
+    if len(blob) < hdr_size + count * TRACE_RECORD_SIZE:
+        raise ValueError("NTXTRACE blob truncated")
+
+    events: list[TraceEvent] = []
+    base: int | None = None
+    prev = 0
+    wraps = 0
+    pos = hdr_size
+    for _ in range(count):
+        t, dur, kind, _reserved, a, b = struct.unpack_from(TRACE_RECORD_FMT, blob, pos)
+        pos += TRACE_RECORD_SIZE
+        if base is None:
+            base = t
+        # Span events carry their start time, so allow small steps backwards.
+        if t + (1 << 31) < prev:
+            wraps += 1
+        prev = t
+        rel = t + (wraps << 32) - base
+        events.append(
+            TraceEvent(
+                t_ms=round(rel * 1000.0 / tick_hz, 2),
+                dur_ms=round(dur * 1000.0 / tick_hz, 2),
+                kind=EVENTS.get(kind, f"event{kind}"),
+                a=a,
+                b=b,
+            )
+        )
+    header = {"tick_hz": tick_hz, "recorded": count, "capacity": capacity, "total": total, "lost": total - count}
+    return header, events
+
+
+def note_titles(manifest_path: Path | None) -> dict[int, str]:
+    if not manifest_path:
+        return {}
+    manifest = json.loads(manifest_path.read_text(encoding="utf-8"))
+    return {n["note_id"]: n["title"] for n in manifest["notes"]}
+
+
+def describe(ev: TraceEvent, titles: dict[int, str]) -> str:
+    def note(nid: int) -> str:
+        return f"'{titles[nid]}'" if nid in titles else f"note {nid}"
+
+    if ev.kind == "session":
+        return f"{ev.a} notes, {ev.b} chunks"
+    if ev.kind == "index_load":
+        return f"{ev.a} notes" + ("" if ev.b else " FAILED")
+    if ev.kind in ("open", "close", "load_fail"):
+        return f"{note(ev.a)} chunk {ev.b + 1}"
+    if ev.kind == "part_read":
+        return f"part {ev.a}: {ev.b} B" if ev.b else f"part {ev.a}: FAILED"
+    if ev.kind == "format_begin":
+        return f"{ev.a} B of text"
+    if ev.kind == "format_end":
+        return f"height {ev.a}" if ev.b else "FAILED"
+    if ev.kind == "draw":
+        return f"scroll {ev.a}"
+    if ev.kind in ("cache_hit", "cache_miss"):
+        return f"part {ev.a}"
+    if ev.kind == "shard_load":
+        return f"shard {ev.a}: {ev.b} notes" if ev.b else f"shard {ev.a}: FAILED"
+    if ev.kind == "dict_read":
+        return f"{ev.a} codes, {ev.b} B expanded" if ev.b else f"{ev.a} codes: FAILED"
+    if ev.kind == "heap":
+        return f"tracked live {ev.a} B, high-water {ev.b} B"
+    if ev.kind == "oom":
+        return f"{OOM_SITES.get(ev.a, f'site {ev.a}')}, {ev.b} B" if ev.b else OOM_SITES.get(ev.a, f"site {ev.a}")
+    return f"a={ev.a} b={ev.b}"
+
+
+def stats(values: list[float]) -> dict:
+    if not values:
+        return {"count": 0}
+    return {
+        "count": len(values),
+        "min_ms": min(values),
+        "median_ms": round(median(values), 2),
+        "max_ms": max(values),
+        "total_ms": round(sum(values), 2),
+    }
+
+
+def summarize(events: list[TraceEvent], titles: dict[int, str]) -> dict:
+    """Per-phase duration stats plus per-open latency: from the open event to
+    the end of the first draw that follows it."""
+    spans: dict[str, list[float]] = {}
+    counts: dict[str, int] = {}
+    opens: list[dict] = []
+    current: dict | None = None
+    for ev in events:
+        counts[ev.kind] = counts.get(ev.kind, 0) + 1
+        if ev.kind in ("index_load", "shard_load", "part_read", "dict_read", "format_end", "draw"):
+            spans.setdefault(ev.kind, []).append(ev.dur_ms)
+        if ev.kind == "open":
+            current = {"note_id": ev.a, "title": titles.get(ev.a), "chunk": ev.b, "t_ms": ev.t_ms, "parts_read": 0}
+            opens.append(current)
+        elif current is not None:
+            if ev.kind == "part_read":
+                current["parts_read"] += 1
+            elif ev.kind == "format_end":
+                current["format_ms"] = ev.dur_ms
+            elif ev.kind == "draw" and "latency_ms" not in current:
+                current["latency_ms"] = round(ev.t_ms + ev.dur_ms - current["t_ms"], 2)
+            elif ev.kind == "heap":
+                current["heap_live"] = ev.a
+            elif ev.kind in ("load_fail", "oom"):
+                current["failed"] = ev.kind
+            elif ev.kind == "close":
+                current = None
+
+    hits = counts.get("cache_hit", 0)
+    misses = counts.get("cache_miss", 0)
+    heap = [ev.b for ev in events if ev.kind == "heap"]
+    return {
+        "counts": counts,
+        "heap_high_water": max(heap) if heap else None,
+        "spans": {k: stats(v) for k, v in spans.items()},
+        "cache_hit_rate": round(hits / (hits + misses), 3) if hits + misses else None,
+        "opens": opens,
+        "slowest_opens": sorted(
+            (o for o in opens if "latency_ms" in o), key=lambda o: o["latency_ms"], reverse=True
+        )[:5],
+    }
+
+
+def print_report(header: dict, events: list[TraceEvent], summary: dict, titles: dict[int, str], timeline: bool) -> None:
+    print(
+        f"NTXTRACE: {header['recorded']} events recorded of {header['total']} "
+        f"({header['lost']} overwritten), {header['tick_hz']} Hz ticks"
+    )
+    if timeline:
+        print(f"\n{'t ms':>10} {'dur ms':>8}  event")
+        for ev in events:
+            dur = f"{ev.dur_ms:8.2f}" if ev.dur_ms else " " * 8
+            print(f"{ev.t_ms:>10.2f} {dur}  {ev.kind:<12} {describe(ev, titles)}")
+
+    print("\nspans:")
+    for kind, s in summary["spans"].items():
+        print(f"  {kind:<12} n={s['count']:<5} median {s['median_ms']:.2f} ms  max {s['max_ms']:.2f} ms")
+    if summary["cache_hit_rate"] is not None:
+        print(f"  cache hit rate {summary['cache_hit_rate'] * 100:.1f}%")
+    if summary["heap_high_water"] is not None:
+        print(f"  tracked heap high-water {summary['heap_high_water']} B")
+    if summary["slowest_opens"]:
+        print("slowest opens (open -> first draw):")
+        for o in summary["slowest_opens"]:
+            name = f"'{o['title']}'" if o["title"] else f"note {o['note_id']}"
+            print(f"  {o['latency_ms']:8.2f} ms  {name} chunk {o['chunk'] + 1} ({o['parts_read']} part reads)")
+    ooms = [ev for ev in events if ev.kind == "oom"]
+    for ev in ooms:
+        print(f"OOM at {ev.t_ms:.2f} ms: {describe(ev, titles)}")
+
+
+def main() -> int:
+    args = parse_args()
+    try:
+        header, events = decode(load_blob(args.trace))
+        titles = note_titles(args.manifest)
+    except (OSError, ValueError, struct.error, KeyError) as e:
+        print(f"ntxtrace: {e}", file=sys.stderr)
+        return 1
+
+    summary = summarize(events, titles)
+    print_report(header, events, summary, titles, not args.no_timeline)
+    if args.json:
+        args.json.write_text(
+            json.dumps({"header": header, "summary": summary, "events": [asdict(e) for e in events]}, indent=2),
+            encoding="utf-8",
+        )
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
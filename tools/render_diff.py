@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Check that build_pack.py's pre-pass (macros, comments, math spacing) does
+not change what the viewer draws.
+
+Packs the notes twice, with and without --no-minify, formats every chunk
+with libtexce through --format-dry-run and compares each note's layout
+height and glyph count. Needs what --format-dry-run needs: the libtexce
+submodule and a host C compiler with CMake.
+
+    python3 tools/render_diff.py
+    python3 tools/render_diff.py --notes-dir path/to/notes
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Compare layouts with and without the packer's pre-pass")
+    p.add_argument("--notes-dir", type=Path, default=ROOT / "notes")
+    p.add_argument("--texdry", type=Path, help="prebuilt texdry binary (passed to build_pack.py)")
+    return p.parse_args()
+
+
+def dry_run(notes_dir: Path, out_dir: Path, texdry: Path | None, minify: bool) -> dict:
+    manifest = out_dir / "pack_manifest.json"
+    cmd = [
+        sys.executable,
+        str(ROOT / "tools/build_pack.py"),
+        "--notes-dir",
+        str(notes_dir),
+        "--out-raw",
+        str(out_dir / "raw"),
+        "--manifest",
+        str(manifest),
+        "--skip-8xv",
+        "--no-cache",
+        "--format-dry-run",
+    ]
+    if texdry:
+        cmd += ["--texdry", str(texdry)]
+    if not minify:
+        cmd.append("--no-minify")
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+    return json.loads(manifest.read_text(encoding="utf-8"))
+
+
+def note_layouts(manifest: dict) -> dict[str, tuple[int, int, int]]:
+    """(chunks, total height, glyphs) per note file."""
+    out = {}
+    for n in manifest["notes"]:
+        chunks = n.get("chunks", [])
+        out[n["key"]] = (
+            len(chunks),
+            sum(c.get("height", -1) for c in chunks),
+            sum(c.get("layout_glyphs", -1) for c in chunks),
+        )
+    return out
+
+
+def main() -> int:
+    args = parse_args()
+    with tempfile.TemporaryDirectory(prefix="render_diff_") as tmp:
+        try:
+            plain = dry_run(args.notes_dir, Path(tmp) / "plain", args.texdry, minify=False)
+            minified = dry_run(args.notes_dir, Path(tmp) / "minified", args.texdry, minify=True)
+        except subprocess.CalledProcessError as e:
+            print(f"render_diff: build failed: {e}", file=sys.stderr)
+            return 1
+    before = note_layouts(plain)
+    after = note_layouts(minified)
+    differ = 0
+    for key in sorted(before):
+        b, a = before[key], after.get(key)
+        if a == b:
+            continue
+        if a is not None and a[0] != b[0]:
+            print(f"{key}: split into {b[0]} -> {a[0]} chunks; compare by eye")
+            continue
+        differ += 1
+        print(f"{key}: height {b[1]} -> {a[1] if a else '-'}, glyphs {b[2]} -> {a[2] if a else '-'}")
+    src = sum(n["text_bytes"] for n in plain["notes"])
+    out = sum(n["text_bytes"] for n in minified["notes"])
+    print(f"{len(before)} notes, {src} -> {out} text bytes, {differ} rendered differently")
+    return 1 if differ else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Read and write TI-83 Premium CE / TI-84 Plus CE variable files (.8xv, .8xg).
+
+Writes the same bytes as `convbin -j bin -k 8xv -r` for AppVars, so the
+packer no longer starts one process per AppVar. A group is the plain
+multi-variable container that TI Connect CE and TILP unpack on send.
+
+    python3 tools/ti8x.py appvar -n NTXIDX -i dist/raw/NTXIDX.bin -o NTXIDX.8xv
+    python3 tools/ti8x.py group -o bundle.8xg dist/8xv/*.8xv viewer.8xp
+"""
+from __future__ import annotations
+
+import argparse
+import struct
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+
+SIGNATURE = b"**TI83F*\x1a\x0a\x00"
+COMMENT_SIZE = 42
+FILE_HEADER_SIZE = len(SIGNATURE) + COMMENT_SIZE + 2  # 55: var entries start here
+# Entry header: header length, data length, type, name[8], version, flag, data length.
+ENTRY_HEADER_FMT = "<HHB8sBBH"
+ENTRY_HEADER_SIZE = struct.calcsize(ENTRY_HEADER_FMT)  # 17
+ENTRY_HEADER_LEN = ENTRY_HEADER_SIZE - 4  # the 13 bytes counted by the first field
+TYPE_APPVAR = 0x15
+FLAG_ARCHIVED = 0x80
+# AppVar data is a u16 size followed by the bytes, and the entry's own length
+# field is 16 bits. (The OS limit is tighter; build_pack.py checks that.)
+MAX_VAR_DATA = 0xFFFF - 2
+
+
+@dataclass
+class VarEntry:
+    name: str
+    type_id: int
+    data: bytes  # includes the leading u16 size word for AppVars and programs
+    archived: bool = True
+    version: int = 0
+
+
+def appvar_entry(name: str, payload: bytes, archived: bool = True) -> VarEntry:
+    if len(payload) > MAX_VAR_DATA:
+        raise ValueError(f"{name}: {len(payload)} bytes is over the {MAX_VAR_DATA}-byte AppVar limit")
+    return VarEntry(name, TYPE_APPVAR, struct.pack("<H", len(payload)) + payload, archived)
+
+
+def entry_bytes(entry: VarEntry) -> bytes:
+    name = entry.name.encode("ascii")
+    if not 1 <= len(name) <= 8:
+        raise ValueError(f"variable name must be 1-8 characters, got {entry.name!r}")
+    header = struct.pack(
+        ENTRY_HEADER_FMT,
+        ENTRY_HEADER_LEN,
+        len(entry.data),
+        entry.type_id,
+        name.ljust(8, b"\0"),
+        entry.version,
+        FLAG_ARCHIVED if entry.archived else 0,
+        len(entry.data),
+    )
+    return header + entry.data
+
+
+def file_bytes(entries: list[VarEntry], comment: bytes = b"") -> bytes:
+    """A complete .8x* file. A group is just several entries under one header
+    and checksum. The length field is 16 bits; groups over 64 KB keep only its
+    low bits, and readers walk the entries instead of trusting it."""
+    if len(comment) > COMMENT_SIZE:
+        raise ValueError(f"comment is over {COMMENT_SIZE} bytes")
+    body = b"".join(entry_bytes(e) for e in entries)
+    checksum = sum(body) & 0xFFFF
+    return (
+        SIGNATURE
+        + comment.ljust(COMMENT_SIZE, b"\0")
+        + struct.pack("<H", len(body) & 0xFFFF)
+        + body
+        + struct.pack("<H", checksum)
+    )
+
+
+def appvar_bytes(name: str, payload: bytes, archived: bool = True) -> bytes:
+    return file_bytes([appvar_entry(name, payload, archived)])
+
+
+def read_entries(data: bytes, source: str = "<bytes>") -> list[VarEntry]:
+    if not data.startswith(SIGNATURE[:8]) or len(data) < FILE_HEADER_SIZE + 2:
+        raise ValueError(f"{source}: not a TI .8x* file")
+    body = data[FILE_HEADER_SIZE:-2]
+    if sum(body) & 0xFFFF != struct.unpack_from("<H", data, len(data) - 2)[0]:
+        raise ValueError(f"{source}: bad checksum")
+    entries = []
+    pos = 0
+    while pos < len(body):
+        if pos + ENTRY_HEADER_SIZE > len(body):
+            raise ValueError(f"{source}: truncated variable entry at byte {FILE_HEADER_SIZE + pos}")
+        hdr_len, size, type_id, name, version, flag, size2 = struct.unpack_from(ENTRY_HEADER_FMT, body, pos)
+        if hdr_len != ENTRY_HEADER_LEN or size != size2 or pos + ENTRY_HEADER_SIZE + size > len(body):
+            raise ValueError(f"{source}: malformed variable entry at byte {FILE_HEADER_SIZE + pos}")
+        start = pos + ENTRY_HEADER_SIZE
+        entries.append(
+            VarEntry(
+                name.rstrip(b"\0").decode("ascii", "replace"),
+                type_id,
+                body[start : start + size],
+                bool(flag & FLAG_ARCHIVED),
+                version,
+            )
+        )
+        pos = start + size
+    return entries
+
+
+def read_file(path: Path) -> list[VarEntry]:
+    return read_entries(path.read_bytes(), str(path))
+
+
+def write_group(inputs: list[Path], out_path: Path) -> None:
+    entries = [e for path in inputs for e in read_file(path)]
+    out_path.write_bytes(file_bytes(entries))
+
+
+def parse_args() -> argparse.Namespace:
+    p = argparse.ArgumentParser(description="Write TI CE .8xv AppVars and .8xg groups")
+    sub = p.add_subparsers(dest="cmd", required=True)
+    a = sub.add_parser("appvar", help="wrap a binary file as an archived AppVar")
+    a.add_argument("-n", "--name", required=True)
+    a.add_argument("-i", "--input", type=Path, required=True)
+    a.add_argument("-o", "--output", type=Path, required=True)
+    a.add_argument("--ram", action="store_true", help="leave the AppVar unarchived")
+    g = sub.add_parser("group", help="combine .8x* files into one .8xg")
+    g.add_argument("-o", "--output", type=Path, required=True)
+    g.add_argument("inputs", type=Path, nargs="+")
+    return p.parse_args()
+
+
+def main() -> int:
+    args = parse_args()
+    try:
+        if args.cmd == "appvar":
+            args.output.write_bytes(appvar_bytes(args.name.upper(), args.input.read_bytes(), not args.ram))
+        else:
+            write_group(args.inputs, args.output)
+    except (OSError, ValueError) as e:
+        print(f"ti8x: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,24 @@
+#ifndef NTX_EMBED_H
+#define NTX_EMBED_H
+
+/* Pack compiled into the program (-DNTX_EMBED_PACK=ON). The definitions are
+ * generated by tools/build_pack.py --emit-c; the blobs have the same layout
+ * as the index, shard and part AppVars, except that every chunk in a part's
+ * payload is followed by a NUL so it can be handed to tex_format in place. */
+
+#include <stdint.h>
+
+typedef struct
+{
+	const uint8_t* data;
+	uint16_t size;
+} NtxEmbedVar;
+
+extern const NtxEmbedVar ntx_embed_index;
+/* Shard N (0-based, as in the root's shard table) is ntx_embed_shards[N]. */
+extern const NtxEmbedVar ntx_embed_shards[];
+/* Part id N is ntx_embed_parts[N - 1]. */
+extern const NtxEmbedVar ntx_embed_parts[];
+extern const uint16_t ntx_embed_part_count;
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NTX_HUD_H
+#define NTX_HUD_H
+
+/* Performance overlay for NTX_HUD builds (configure with -DNTX_HUD=ON).
+ * [mode] toggles it; it shows the last chunk load, tex_format, tex_draw and
+ * swap times from ntx_perf plus the largest free heap block, and tracked
+ * live/high-water bytes in NTX_MEM_TRACK builds. Without NTX_HUD
+ * every macro below compiles to nothing. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef NTX_HUD
+
+void ntx_hud_init(size_t slab_size);
+void ntx_hud_poll(void);
+void ntx_hud_sample_heap(void);
+void ntx_hud_draw_menu(void);
+void ntx_hud_draw_view(void);
+
+#define NTX_HUD_INIT(slab_size) ntx_hud_init(slab_size)
+#define NTX_HUD_POLL() ntx_hud_poll()
+#define NTX_HUD_SAMPLE_HEAP() ntx_hud_sample_heap()
+#define NTX_HUD_DRAW_MENU() ntx_hud_draw_menu()
+#define NTX_HUD_DRAW_VIEW() ntx_hud_draw_view()
+
+#else
+
+#define NTX_HUD_INIT(slab_size) ((void)0)
+#define NTX_HUD_POLL() ((void)0)
+#define NTX_HUD_SAMPLE_HEAP() ((void)0)
+#define NTX_HUD_DRAW_MENU() ((void)0)
+#define NTX_HUD_DRAW_VIEW() ((void)0)
+
+#endif
+
+#endif
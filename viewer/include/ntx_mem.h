@@ -0,0 +1,62 @@
+#ifndef NTX_MEM_H
+#define NTX_MEM_H
+
+/* Tagged allocation layer for main.c and ntx_pack.c. With NTX_MEM_TRACK
+ * (configure with -DNTX_MEM_TRACK=ON) every block carries a small header so
+ * live bytes, per-tag peaks and the overall high-water mark can be reported;
+ * otherwise NTX_MALLOC/NTX_CALLOC/NTX_FREE are plain malloc/calloc/free.
+ * Titles returned by ntx_load_index must go back through NTX_FREE. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef enum
+{
+	NTX_MEM_INDEX = 0, /* index and shard buffers, shard table, note entries */
+	NTX_MEM_TITLE,
+	NTX_MEM_CHUNK, /* the chunk text buffer, sized from the index at startup */
+	NTX_MEM_RENDERER, /* accounted, allocated inside libtexce */
+	NTX_MEM_TAG_COUNT
+} NtxMemTag;
+
+typedef struct
+{
+	size_t live[NTX_MEM_TAG_COUNT];
+	size_t peak[NTX_MEM_TAG_COUNT];
+	size_t live_total;
+	size_t high_water;
+	uint32_t allocs;
+	uint32_t failures;
+} NtxMemStats;
+
+/* Largest block malloc currently hands out, found by binary search. Costs
+ * about 16 malloc/free pairs; never call it per frame. */
+size_t ntx_mem_largest_free(void);
+
+const char* ntx_mem_tag_name(NtxMemTag tag);
+
+#ifdef NTX_MEM_TRACK
+
+void* ntx_mem_alloc(size_t size, NtxMemTag tag);
+void* ntx_mem_calloc(size_t count, size_t size, NtxMemTag tag);
+void ntx_mem_free(void* ptr);
+void ntx_mem_account(NtxMemTag tag, size_t size, bool add);
+void ntx_mem_stats(NtxMemStats* out);
+
+#define NTX_MALLOC(size, tag) ntx_mem_alloc((size), (tag))
+#define NTX_CALLOC(count, size, tag) ntx_mem_calloc((count), (size), (tag))
+#define NTX_FREE(ptr) ntx_mem_free(ptr)
+#define NTX_MEM_ACCOUNT(tag, size, add) ntx_mem_account((tag), (size), (add))
+
+#else
+
+#define NTX_MALLOC(size, tag) ((void)(tag), malloc(size))
+#define NTX_CALLOC(count, size, tag) ((void)(tag), calloc((count), (size)))
+#define NTX_FREE(ptr) free(ptr)
+#define NTX_MEM_ACCOUNT(tag, size, add) ((void)0)
+
+#endif
+
+#endif
@@ -5,26 +5,135 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* A pack is named by a 1-4 character prefix: its index is <prefix>IDX, its
+ * note entries are split over shards <prefix>S000.. and its parts are
+ * <prefix> plus the part id in four base-36 digits. Packs built before
+ * prefixes existed use NTX. */
+#define NTX_PREFIX_MAX 4U
+#define NTX_DEFAULT_INDEX "NTXIDX"
+/* Shards kept in RAM at once; two let the menu straddle a shard boundary. */
+#define NTX_SHARD_SLOTS 2U
+
 typedef struct
 {
 	uint16_t note_id;
 	uint16_t first_part_id;
 	uint16_t part_count;
-	uint16_t total_chunks;
+	uint32_t total_chunks;
 	uint32_t total_text_bytes;
 	char* title;
 } NtxNoteEntry;
 
+/* Root record of one shard: which notes it holds and their chunk total, so
+ * the menu can count and place rows without loading the shard. */
 typedef struct
 {
+	uint16_t first_note;
+	uint16_t note_count;
+	uint32_t total_chunks;
+} NtxShardInfo;
+
+typedef struct
+{
+	uint16_t shard; /* NTX_SHARD_NONE when empty */
 	uint16_t count;
 	NtxNoteEntry* entries;
+} NtxShardSlot;
+
+#define NTX_SHARD_NONE 0xFFFFU
+
+/* ntx_load_index reads only the root: the header and the shard table. Note
+ * entries are read by ntx_index_note, a shard at a time. max_* come from the
+ * root header: the packer records the longest chunk, the largest part AppVar
+ * and the largest tex_format heap peak it measured (0 when built without
+ * --format-dry-run), so the viewer can size its buffers once. dict_count is
+ * the number of entries in the pack dictionary <prefix>DIC (0 for none). */
+typedef struct
+{
+	char prefix[NTX_PREFIX_MAX + 1];
+	uint16_t count;
+	uint16_t shard_count;
+	uint16_t max_chunk_len;
+	uint16_t max_part_size;
+	uint32_t max_layout_bytes;
+	uint16_t dict_count;
+	uint32_t total_chunks;
+	NtxShardInfo* shards;
+	NtxShardSlot slots[NTX_SHARD_SLOTS];
+	uint8_t last_slot;
 } NtxIndex;
 
-bool ntx_load_index(NtxIndex* out, char* err, size_t err_len);
+/* One installed pack as seen by ntx_find_packs; only the index header is read. */
+typedef struct
+{
+	char index_name[9];
+	char prefix[NTX_PREFIX_MAX + 1];
+	uint16_t note_count;
+} NtxPackInfo;
+
+/* Fills out with up to max packs found by scanning for index AppVars and
+ * returns how many there are. */
+uint8_t ntx_find_packs(NtxPackInfo* out, uint8_t max);
+bool ntx_load_index(const char* index_name, NtxIndex* out, char* err, size_t err_len);
 void ntx_free_index(NtxIndex* index);
-void ntx_part_name_from_id(uint16_t id, char out_name[9]);
-bool ntx_load_chunk_text(const NtxNoteEntry* note, uint16_t global_chunk_index, char** out_text, uint16_t* out_len,
-                         uint8_t* out_split_kind, char* err, size_t err_len);
+/* Returns note note_index (0-based), loading its shard first if needed and
+ * evicting the least recently used one. The pointer stays valid until a call
+ * for a note in a third shard; NULL with err set when the shard fails. */
+const NtxNoteEntry* ntx_index_note(NtxIndex* index, uint16_t note_index, char* err, size_t err_len);
+void ntx_part_name_from_id(const char* prefix, uint16_t id, char out_name[9]);
+/* Pull reader over one chunk. It reads the part and the dictionary in place
+ * and expands codes as the caller asks for bytes, so a consumer that scans a
+ * chunk needs only its own window. The part and dictionary AppVars stay open
+ * until ntx_chunk_close. */
+typedef struct
+{
+	const uint8_t* src; /* stored bytes not yet decoded */
+	uint16_t src_left;
+	const uint8_t* pending; /* rest of the dictionary entry being copied out */
+	uint16_t pending_left;
+	const uint8_t* dict_table;
+	const uint8_t* dict_payload;
+	uint16_t dict_payload_size;
+	uint16_t dict_count; /* 0: the chunk is plain text */
+	uint16_t codes;      /* codes expanded so far */
+	uint8_t split_kind;
+	uint8_t part_var;
+	uint8_t dict_var;
+	const char* error; /* set when ntx_chunk_read fails */
+} NtxChunkReader;
+
+bool ntx_chunk_open(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, NtxChunkReader* r,
+                    char* err, size_t err_len);
+/* Copies up to cap text bytes to dst and returns how many; 0 at the end of the
+ * chunk, -1 on a bad dictionary code (r->error says which). */
+int ntx_chunk_read(NtxChunkReader* r, char* dst, uint16_t cap);
+void ntx_chunk_close(NtxChunkReader* r);
+/* Reads one chunk into buf as a NUL-terminated string without allocating and
+ * points *out_text at it; buf_size must be at least index.max_chunk_len + 1.
+ * Dictionary codes are expanded on the way in. With a compiled-in pack
+ * (NTX_EMBEDDED) *out_text points straight at the chunk in the program and
+ * buf may be NULL. */
+bool ntx_load_chunk_text(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, char* buf,
+                         uint16_t buf_size, const char** out_text, uint16_t* out_len, uint8_t* out_split_kind,
+                         char* err, size_t err_len);
+
+/* Where a chunk sits in its note's rendered height, in pixels at the packer's
+ * content width. The heights come from its --format-dry-run; every field is 0
+ * when the pack (or any chunk of the note) has none. */
+typedef struct
+{
+	uint32_t chunk;
+	uint32_t top; /* summed height of the chunks before it */
+	uint16_t height;
+	uint32_t note_height;
+} NtxChunkPlace;
+
+/* Both read only the chunk tables of the note's parts, never chunk text. */
+bool ntx_chunk_place(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, NtxChunkPlace* out,
+                     char* err, size_t err_len);
+/* Finds the chunk covering y pixels from the top of the note (the last chunk
+ * when y is past the end). */
+bool ntx_chunk_place_at(const NtxIndex* index, const NtxNoteEntry* note, uint32_t y, NtxChunkPlace* out, char* err,
+                        size_t err_len);
 
 #endif
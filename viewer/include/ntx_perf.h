@@ -0,0 +1,62 @@
+#ifndef NTX_PERF_H
+#define NTX_PERF_H
+
+/* Phase timing for instrumented viewer builds. Cycles come from a free-running
+ * CPU-clock timer. NTX_PERF (configure with -DNTX_PERF=ON) keeps per-phase
+ * statistics and writes them to the NTXPERF AppVar, echoed to the CEmu debug
+ * console, on exit; NTX_HUD only keeps the last sample of each phase for the
+ * overlay. With neither defined every macro below compiles to nothing. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+	NTX_PHASE_INDEX_LOAD = 0,
+	NTX_PHASE_MENU_BUILD,
+	NTX_PHASE_MENU_FRAME,
+	NTX_PHASE_OPEN,
+	NTX_PHASE_CHUNK_LOAD,
+	NTX_PHASE_FORMAT,
+	NTX_PHASE_FRAME,
+	NTX_PHASE_TEX_DRAW,
+	NTX_PHASE_SWAP,
+	NTX_PHASE_COUNT
+} NtxPerfPhase;
+
+#define NTX_PERF_CLOCK_HZ 48000000UL
+
+#if defined(NTX_PERF) || defined(NTX_HUD)
+#define NTX_TIMING
+#endif
+
+#ifdef NTX_TIMING
+
+void ntx_perf_init(void);
+uint32_t ntx_perf_now(void);
+void ntx_perf_set_tag(uint16_t tag);
+void ntx_perf_record(NtxPerfPhase phase, uint32_t start);
+uint32_t ntx_perf_last(NtxPerfPhase phase);
+
+#define NTX_PERF_INIT() ntx_perf_init()
+#define NTX_PERF_TAG(tag) ntx_perf_set_tag((uint16_t)(tag))
+#define NTX_PERF_START(var) const uint32_t var = ntx_perf_now()
+#define NTX_PERF_END(phase, var) ntx_perf_record((phase), (var))
+
+#else
+
+#define NTX_PERF_INIT() ((void)0)
+#define NTX_PERF_TAG(tag) ((void)0)
+#define NTX_PERF_START(var) ((void)0)
+#define NTX_PERF_END(phase, var) ((void)0)
+
+#endif
+
+#ifdef NTX_PERF
+bool ntx_perf_flush(void);
+#define NTX_PERF_FLUSH() ((void)ntx_perf_flush())
+#else
+#define NTX_PERF_FLUSH() ((void)0)
+#endif
+
+#endif
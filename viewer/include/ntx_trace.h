@@ -0,0 +1,78 @@
+#ifndef NTX_TRACE_H
+#define NTX_TRACE_H
+
+/* Event trace kept in a fixed RAM ring buffer and written to the NTXTRACE
+ * AppVar on exit; decode with tools/ntxtrace.py. Timestamps come from a
+ * 32768 Hz hardware timer, so recording an event is one timer read and a
+ * 12-byte store. Configure with -DNTX_TRACE=OFF to compile it out. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Event types; keep in sync with EVENTS in tools/ntxtrace.py. */
+typedef enum
+{
+	NTX_EV_SESSION = 1, /* a: note count, b: chunk count */
+	NTX_EV_INDEX_LOAD, /* span; a: note count, b: ok (root only) */
+	NTX_EV_OPEN, /* a: note id, b: chunk index */
+	NTX_EV_CLOSE, /* a: note id, b: chunk index */
+	NTX_EV_PART_READ, /* span; a: part id, b: bytes read (0 on failure) */
+	NTX_EV_FORMAT_BEGIN, /* a: text bytes */
+	NTX_EV_FORMAT_END, /* span; a: layout height, b: ok */
+	NTX_EV_DRAW, /* span; a: scroll y */
+	NTX_EV_CACHE_HIT, /* a: part id */
+	NTX_EV_CACHE_MISS, /* a: part id */
+	NTX_EV_OOM, /* a: NtxOomSite, b: requested bytes (saturated) */
+	NTX_EV_LOAD_FAIL, /* a: note id, b: chunk index */
+	NTX_EV_HEAP, /* NTX_MEM_TRACK only; a: tracked live bytes, b: tracked high-water (saturated) */
+	NTX_EV_SHARD_LOAD, /* span; a: shard, b: note count (0 on failure) */
+	NTX_EV_DICT_READ /* span; a: dictionary codes expanded, b: expanded chunk bytes (0 on failure) */
+} NtxTraceEvent;
+
+typedef enum
+{
+	NTX_OOM_APPVAR_BUF = 1,
+	NTX_OOM_INDEX_ENTRIES,
+	NTX_OOM_TITLE,
+	NTX_OOM_CHUNK_TEXT,
+	NTX_OOM_MENU, /* unused since the chunk menu stopped allocating; kept for decoders */
+	NTX_OOM_LAYOUT,
+	NTX_OOM_RENDERER
+} NtxOomSite;
+
+#ifdef NTX_TRACE
+
+void ntx_trace_init(void);
+uint32_t ntx_trace_now(void);
+void ntx_trace_event(NtxTraceEvent type, uint16_t a, uint16_t b);
+void ntx_trace_span(NtxTraceEvent type, uint16_t a, uint16_t b, uint32_t start);
+void ntx_trace_oom(NtxOomSite site, size_t size);
+bool ntx_trace_flush(void);
+
+#define NTX_TRACE_INIT() ntx_trace_init()
+#define NTX_TRACE_EV(type, a, b) ntx_trace_event((type), (uint16_t)(a), (uint16_t)(b))
+#define NTX_TRACE_BEGIN(var) const uint32_t var = ntx_trace_now()
+#define NTX_TRACE_SPAN(type, a, b, var) ntx_trace_span((type), (uint16_t)(a), (uint16_t)(b), (var))
+#define NTX_TRACE_OOM(site, size) ntx_trace_oom((site), (size_t)(size))
+#define NTX_TRACE_FLUSH() ((void)ntx_trace_flush())
+
+#else
+
+#define NTX_TRACE_INIT() ((void)0)
+#define NTX_TRACE_EV(type, a, b) ((void)0)
+#define NTX_TRACE_BEGIN(var) ((void)0)
+#define NTX_TRACE_SPAN(type, a, b, var) ((void)0)
+#define NTX_TRACE_OOM(site, size) ((void)0)
+#define NTX_TRACE_FLUSH() ((void)0)
+
+#endif
+
+#if defined(NTX_TRACE) && defined(NTX_MEM_TRACK)
+void ntx_trace_heap(void);
+#define NTX_TRACE_HEAP() ntx_trace_heap()
+#else
+#define NTX_TRACE_HEAP() ((void)0)
+#endif
+
+#endif
@@ -1,4 +1,8 @@
+#include "ntx_hud.h"
+#include "ntx_mem.h"
 #include "ntx_pack.h"
+#include "ntx_perf.h"
+#include "ntx_trace.h"
 
 #include <fontlibc.h>
 #include <graphx.h>
@@ -20,11 +24,15 @@
 #define UI_COL_ACCENT 252
 #define UI_COL_BORDER 253
 #define RENDERER_SLAB_SIZE ((size_t)20 * 1024)
+#define MAX_PACKS 10
 
+/* The chunk menu lists every chunk of the pack in note order without storing
+ * the list: a cursor names one row and steps to its neighbours, so a pack of
+ * any size costs no menu memory. */
 typedef struct
 {
 	uint16_t note_index;
-	uint16_t chunk_index;
+	uint32_t chunk_index;
 } ChunkMenuItem;
 
 static void setup_menu_palette(void)
@@ -96,42 +104,87 @@ static bool require_fontpacks(fontlib_font_t** out_main, fontlib_font_t** out_sc
 	return false;
 }
 
-static bool build_chunk_menu(const NtxIndex* idx, ChunkMenuItem** out_items, uint16_t* out_count)
+/* Chunk count of note n; a note whose shard cannot be loaded counts as empty
+ * and is skipped. */
+static uint32_t note_chunks(NtxIndex* idx, uint16_t n)
 {
-	if (!idx || !out_items || !out_count)
-		return false;
-	*out_items = NULL;
-	*out_count = 0;
-
-	uint32_t total = 0;
-	for (uint16_t i = 0; i < idx->count; ++i)
-		total += idx->entries[i].total_chunks;
-
-	if (total == 0 || total > 0xFFFFu)
-		return true;
+	const NtxNoteEntry* note = ntx_index_note(idx, n, NULL, 0);
+	return note ? note->total_chunks : 0;
+}
 
-	ChunkMenuItem* items = (ChunkMenuItem*)calloc((size_t)total, sizeof(ChunkMenuItem));
-	if (!items)
+/* Moves the cursor one row down (or up), skipping notes without chunks.
+ * Returns false and leaves it unchanged at either end of the list. */
+static bool menu_step(NtxIndex* idx, ChunkMenuItem* it, bool down)
+{
+	if (down)
+	{
+		if (it->chunk_index + 1 < note_chunks(idx, it->note_index))
+		{
+			it->chunk_index++;
+			return true;
+		}
+		for (uint16_t n = (uint16_t)(it->note_index + 1); n < idx->count; ++n)
+		{
+			if (note_chunks(idx, n) > 0)
+			{
+				it->note_index = n;
+				it->chunk_index = 0;
+				return true;
+			}
+		}
 		return false;
+	}
 
-	uint32_t pos = 0;
-	for (uint16_t n = 0; n < idx->count; ++n)
+	if (it->chunk_index > 0)
+	{
+		it->chunk_index--;
+		return true;
+	}
+	for (uint16_t n = it->note_index; n-- > 0;)
 	{
-		const NtxNoteEntry* note = &idx->entries[n];
-		for (uint16_t c = 0; c < note->total_chunks; ++c)
+		const uint32_t chunks = note_chunks(idx, n);
+		if (chunks > 0)
 		{
-			items[pos].note_index = n;
-			items[pos].chunk_index = c;
-			pos++;
+			it->note_index = n;
+			it->chunk_index = chunks - 1;
+			return true;
 		}
 	}
+	return false;
+}
 
-	*out_items = items;
-	*out_count = (uint16_t)total;
-	return true;
+/* Cursor on the first row; false when the pack has no chunks. */
+static bool menu_first(NtxIndex* idx, ChunkMenuItem* out)
+{
+	out->note_index = 0;
+	out->chunk_index = 0;
+	if (idx->count == 0)
+		return false;
+	return note_chunks(idx, 0) > 0 || menu_step(idx, out, true);
+}
+
+/* A 2 px track at x with a thumb for the visible span [pos, pos + view) of
+ * total. 64-bit products: a u32 row count or a note's
+ * height times the track height overflows. */
+static void draw_scrollbar(int x, int y, int h, uint32_t pos, uint32_t view, uint32_t total)
+{
+	if (total <= view)
+		return;
+	int thumb_h = (int)(((uint64_t)h * (uint64_t)view) / total);
+	if (thumb_h < 10)
+		thumb_h = 10;
+	const int travel = h - thumb_h;
+	const uint32_t denom = total - view;
+	const int thumb_y = y + (int)(((uint64_t)travel * ((pos < denom) ? pos : denom)) / denom);
+
+	gfx_SetColor(UI_COL_BORDER);
+	gfx_FillRectangle(x, y, 2, h);
+	gfx_SetColor(UI_COL_ACCENT);
+	gfx_FillRectangle(x, thumb_y, 2, thumb_h);
 }
 
-static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uint16_t count, int sel)
+static void draw_chunk_menu(NtxIndex* idx, const ChunkMenuItem* cursor, uint32_t count, uint32_t sel,
+                            bool can_go_back)
 {
 	gfx_FillScreen(UI_COL_BG);
 
@@ -139,10 +192,11 @@ static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uin
 	gfx_FillRectangle_NoClip(0, 0, GFX_LCD_WIDTH, 20);
 	gfx_SetTextFGColor(255);
 	gfx_SetTextXY(6, 6);
-	gfx_PrintString("notes_viewer");
+	gfx_PrintString("notes_viewer ");
+	gfx_PrintString(idx->prefix);
 
 	char hdr[48];
-	snprintf(hdr, sizeof(hdr), "chunks:%u", (unsigned)count);
+	snprintf(hdr, sizeof(hdr), "chunks:%lu", (unsigned long)count);
 	int hdr_w = (int)gfx_GetStringWidth(hdr);
 	gfx_SetTextXY(GFX_LCD_WIDTH - hdr_w - 6, 6);
 	gfx_PrintString(hdr);
@@ -151,13 +205,14 @@ static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uin
 	gfx_FillRectangle_NoClip(0, GFX_LCD_HEIGHT - 12, GFX_LCD_WIDTH, 12);
 	gfx_SetTextFGColor(COL_FG);
 	gfx_SetTextXY(6, GFX_LCD_HEIGHT - 10);
-	gfx_PrintString("UP/DOWN:Move ENTER:Open CLEAR:Exit");
+	gfx_PrintString(can_go_back ? "UP/DOWN:Move ENTER:Open CLEAR:Packs" : "UP/DOWN:Move ENTER:Open CLEAR:Exit");
 
-	if (!items || count == 0)
+	if (!cursor || count == 0)
 	{
 		gfx_SetTextFGColor(COL_FG);
 		gfx_SetTextXY(6, 30);
 		gfx_PrintString("No chunks available.");
+		NTX_HUD_DRAW_MENU();
 		gfx_SwapDraw();
 		return;
 	}
@@ -168,22 +223,26 @@ static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uin
 	const int list_h = GFX_LCD_HEIGHT - list_y - 16;
 	const int row_h = 18;
 	const int visible_rows = list_h / row_h;
-	int top = sel - (visible_rows / 2);
-	if (top < 0)
-		top = 0;
-	if (top > (int)count - visible_rows)
-		top = (int)count - visible_rows;
-	if (top < 0)
+	uint32_t top = (sel > (uint32_t)(visible_rows / 2)) ? sel - (uint32_t)(visible_rows / 2) : 0;
+	if (count > (uint32_t)visible_rows && top > count - (uint32_t)visible_rows)
+		top = count - (uint32_t)visible_rows;
+	if (count <= (uint32_t)visible_rows)
 		top = 0;
 
+	/* Walk back from the selection to the top row; at most one screenful. */
+	ChunkMenuItem row = *cursor;
+	for (uint32_t i = sel; i > top; --i)
+		menu_step(idx, &row, false);
+
 	int y = list_y;
 	for (int r = 0; r < visible_rows; ++r)
 	{
-		int i = top + r;
-		if (i >= count)
+		const uint32_t i = top + (uint32_t)r;
+		if (i >= count || (r > 0 && !menu_step(idx, &row, true)))
+			break;
+		const NtxNoteEntry* note = ntx_index_note(idx, row.note_index, NULL, 0);
+		if (!note)
 			break;
-		const ChunkMenuItem* mi = &items[i];
-		const NtxNoteEntry* note = &idx->entries[mi->note_index];
 
 		const bool is_sel = (i == sel);
 		gfx_SetColor(is_sel ? UI_COL_SEL : UI_COL_PANEL);
@@ -192,7 +251,7 @@ static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uin
 		gfx_Rectangle(list_x, y, list_w, row_h - 2);
 
 		char rhs[20];
-		snprintf(rhs, sizeof(rhs), "%u/%u", (unsigned)(mi->chunk_index + 1), (unsigned)note->total_chunks);
+		snprintf(rhs, sizeof(rhs), "%lu/%lu", (unsigned long)row.chunk_index + 1, (unsigned long)note->total_chunks);
 		const int rhs_w = (int)gfx_GetStringWidth(rhs);
 
 		gfx_SetTextFGColor(COL_FG);
@@ -203,24 +262,9 @@ static void draw_chunk_menu(const NtxIndex* idx, const ChunkMenuItem* items, uin
 		y += row_h;
 	}
 
-	if ((int)count > visible_rows)
-	{
-		const int track_x = GFX_LCD_WIDTH - 6;
-		const int track_y = list_y;
-		const int track_h = list_h;
-		int thumb_h = (track_h * visible_rows) / (int)count;
-		if (thumb_h < 10)
-			thumb_h = 10;
-		const int travel = track_h - thumb_h;
-		const int denom = (int)count - visible_rows;
-		const int thumb_y = track_y + ((denom > 0) ? ((travel * top) / denom) : 0);
-
-		gfx_SetColor(UI_COL_BORDER);
-		gfx_FillRectangle(track_x, track_y, 2, track_h);
-		gfx_SetColor(UI_COL_ACCENT);
-		gfx_FillRectangle(track_x, thumb_y, 2, thumb_h);
-	}
+	draw_scrollbar(GFX_LCD_WIDTH - 6, list_y, list_h, top, (uint32_t)visible_rows, count);
 
+	NTX_HUD_DRAW_MENU();
 	gfx_SwapDraw();
 }
 
@@ -237,14 +281,42 @@ static void wait_for_nav_key_release(void)
 	}
 }
 
-static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_Renderer* renderer)
+/* Digit key down in the last scan, or -1. */
+static int held_digit(void)
+{
+	static const uint8_t group[10] = { 3, 3, 4, 5, 3, 4, 5, 3, 4, 5 };
+	static const uint8_t mask[10] = { kb_0, kb_1, kb_2, kb_3, kb_4, kb_5, kb_6, kb_7, kb_8, kb_9 };
+	for (int d = 0; d < 10; ++d)
+	{
+		if (kb_Data[group[d]] & mask[d])
+			return d;
+	}
+	return -1;
+}
+
+/* Shows chunk *io_chunk from *io_scroll pixels down. Digit keys jump to that
+ * tenth of the note: when the packer stored chunk heights the target may lie
+ * in another chunk, and the function returns true with *io_chunk and
+ * *io_scroll naming it, without formatting the chunks in between. text_buf is
+ * the pack's buffer from alloc_view_buffers in run_pack(); every open of that
+ * pack reuses it. */
+static bool view_chunk_tex(const NtxIndex* idx, const NtxNoteEntry* note, uint32_t* io_chunk, int* io_scroll,
+                           TeX_Renderer* renderer, char* text_buf, uint16_t text_cap)
 {
+	const uint32_t chunk_index = *io_chunk;
 	char err[64] = { 0 };
-	char* text = NULL;
+	const char* text = NULL;
 	uint16_t text_len = 0;
 	uint8_t split_kind = 0;
-	if (!ntx_load_chunk_text(note, chunk_index, &text, &text_len, &split_kind, err, sizeof(err)))
+	NTX_PERF_START(t_open);
+	NTX_TRACE_EV(NTX_EV_OPEN, note->note_id, chunk_index);
+	NTX_PERF_START(t_load);
+	const bool loaded = ntx_load_chunk_text(idx, note, chunk_index, text_buf, text_cap, &text, &text_len,
+	                                        &split_kind, err, sizeof(err));
+	NTX_PERF_END(NTX_PHASE_CHUNK_LOAD, t_load);
+	if (!loaded)
 	{
+		NTX_TRACE_EV(NTX_EV_LOAD_FAIL, note->note_id, chunk_index);
 		gfx_FillScreen(COL_BG);
 		gfx_SetTextFGColor(COL_FG);
 		gfx_SetTextXY(4, 10);
@@ -260,11 +332,10 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 			if (kb_Data[6] & kb_Clear)
 				break;
 		}
-		return;
+		return false;
 	}
 	if (!renderer)
 	{
-		free(text);
 		gfx_FillScreen(COL_BG);
 		gfx_SetTextFGColor(COL_FG);
 		gfx_SetTextXY(4, 10);
@@ -278,7 +349,7 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 			if (kb_Data[6] & kb_Clear)
 				break;
 		}
-		return;
+		return false;
 	}
 
 	TeX_Config cfg = {
@@ -294,17 +365,33 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 	const int content_width = GFX_LCD_WIDTH - (margin * 2);
 	const int viewport_h = GFX_LCD_HEIGHT - header_h - footer_h;
 
+	NTX_TRACE_EV(NTX_EV_FORMAT_BEGIN, text_len, 0);
+	NTX_TRACE_BEGIN(t_trace_format);
+	NTX_PERF_START(t_format);
 	TeX_Layout* layout = tex_format(text, content_width, &cfg);
+	NTX_PERF_END(NTX_PHASE_FORMAT, t_format);
+	NTX_TRACE_SPAN(NTX_EV_FORMAT_END, layout ? tex_get_total_height(layout) : 0, layout != NULL, t_trace_format);
+	NTX_TRACE_HEAP();
+	if (!layout)
+		NTX_TRACE_OOM(NTX_OOM_LAYOUT, text_len);
 	tex_renderer_invalidate(renderer);
+	NTX_HUD_SAMPLE_HEAP();
 
-	int scroll_y = 0;
 	int total_h = layout ? tex_get_total_height(layout) : 0;
 	int max_scroll = (total_h > viewport_h) ? (total_h - viewport_h) : 0;
+	int scroll_y = (*io_scroll < max_scroll) ? *io_scroll : max_scroll;
+	NtxChunkPlace place;
+	if (!ntx_chunk_place(idx, note, chunk_index, &place, NULL, 0))
+		place.note_height = 0;
+	bool jump = false;
 
 	bool prev_up = false;
 	bool prev_down = false;
 	bool prev_clear = false;
 	bool prev_2nd = false;
+	int prev_digit = held_digit(); /* still down after a jump here */
+	bool first_frame = true;
+	int traced_scroll = -1;
 
 	while (true)
 	{
@@ -313,16 +400,20 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 		bool now_down = (kb_Data[7] & kb_Down) != 0;
 		bool now_clear = (kb_Data[6] & kb_Clear) != 0;
 		bool now_2nd = (kb_Data[1] & kb_2nd) != 0;
+		int now_digit = held_digit();
+		NTX_HUD_POLL();
 
 		bool up_press = now_up && !prev_up;
 		bool down_press = now_down && !prev_down;
 		bool clear_press = now_clear && !prev_clear;
 		bool second_press = now_2nd && !prev_2nd;
+		int digit_press = (now_digit != prev_digit) ? now_digit : -1;
 
 		prev_up = now_up;
 		prev_down = now_down;
 		prev_clear = now_clear;
 		prev_2nd = now_2nd;
+		prev_digit = now_digit;
 
 		if (up_press && scroll_y > 0)
 		{
@@ -336,24 +427,51 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 			if (scroll_y > max_scroll)
 				scroll_y = max_scroll;
 		}
+		if (digit_press >= 0 && place.note_height == 0)
+			scroll_y = (int)(((int32_t)max_scroll * digit_press) / 9);
+		else if (digit_press >= 0)
+		{
+			const uint32_t span = (place.note_height > (uint32_t)viewport_h) ? place.note_height - viewport_h : 0;
+			const uint32_t y = (uint32_t)(((uint64_t)span * (uint64_t)digit_press) / 9U);
+			NtxChunkPlace dest;
+			if (y >= place.top && y < place.top + place.height)
+				scroll_y = ((int)(y - place.top) < max_scroll) ? (int)(y - place.top) : max_scroll;
+			else if (ntx_chunk_place_at(idx, note, y, &dest, NULL, 0) && dest.note_height > 0)
+			{
+				*io_chunk = dest.chunk;
+				*io_scroll = (int)(y - dest.top);
+				jump = true;
+				break;
+			}
+		}
 		if (clear_press || second_press)
 			break;
 
+		NTX_PERF_START(t_frame);
 		gfx_FillScreen(COL_BG);
 		gfx_SetTextFGColor(COL_FG);
 		gfx_SetTextXY(2, 1);
 		gfx_PrintString(note->title ? note->title : "(untitled)");
 
 		char hdr[64];
-		snprintf(hdr, sizeof(hdr), "chunk %u/%u k=%u", (unsigned)(chunk_index + 1), (unsigned)note->total_chunks,
-		         (unsigned)split_kind);
+		snprintf(hdr, sizeof(hdr), "chunk %lu/%lu k=%u", (unsigned long)chunk_index + 1,
+		         (unsigned long)note->total_chunks, (unsigned)split_kind);
 		gfx_SetTextXY(180, 1);
 		gfx_PrintString(hdr);
 
 		if (layout)
 		{
 			gfx_SetClipRegion(0, header_h, GFX_LCD_WIDTH, GFX_LCD_HEIGHT - footer_h);
+			NTX_PERF_START(t_draw);
+			NTX_TRACE_BEGIN(t_trace_draw);
 			tex_draw(renderer, layout, margin, header_h, scroll_y);
+			NTX_PERF_END(NTX_PHASE_TEX_DRAW, t_draw);
+			/* Only draws the user waits on; idle redraws would flood the ring. */
+			if (scroll_y != traced_scroll)
+			{
+				NTX_TRACE_SPAN(NTX_EV_DRAW, scroll_y, 0, t_trace_draw);
+				traced_scroll = scroll_y;
+			}
 			gfx_SetClipRegion(0, 0, GFX_LCD_WIDTH, GFX_LCD_HEIGHT);
 		}
 		else
@@ -362,79 +480,226 @@ static void view_chunk_tex(const NtxNoteEntry* note, uint16_t chunk_index, TeX_R
 			gfx_PrintString("render init failed");
 		}
 
+		/* The note-wide position when the pack has heights, else the chunk's. */
+		if (place.note_height > 0)
+			draw_scrollbar(GFX_LCD_WIDTH - 3, header_h, viewport_h, place.top + (uint32_t)scroll_y,
+			               (uint32_t)viewport_h, place.note_height);
+		else
+			draw_scrollbar(GFX_LCD_WIDTH - 3, header_h, viewport_h, (uint32_t)scroll_y, (uint32_t)viewport_h,
+			               (uint32_t)total_h);
+
 		gfx_SetTextXY(2, GFX_LCD_HEIGHT - 9);
-		gfx_PrintString("CLEAR/2ND:Back");
+		gfx_PrintString("CLEAR/2ND:Back 0-9:Jump");
+		if (place.note_height > 0)
+		{
+			/* How much of the note has been on screen, like a pager. */
+			const uint32_t seen = place.top + (uint32_t)scroll_y + (uint32_t)viewport_h;
+			char pct[8];
+			snprintf(pct, sizeof(pct), "%u%%",
+			         (seen >= place.note_height) ? 100U : (unsigned)(((uint64_t)seen * 100U) / place.note_height));
+			gfx_SetTextXY(GFX_LCD_WIDTH - (int)gfx_GetStringWidth(pct) - 6, GFX_LCD_HEIGHT - 9);
+			gfx_PrintString(pct);
+		}
+		NTX_HUD_DRAW_VIEW();
+		NTX_PERF_START(t_swap);
 		gfx_SwapDraw();
+		NTX_PERF_END(NTX_PHASE_SWAP, t_swap);
+		NTX_PERF_END(NTX_PHASE_FRAME, t_frame);
+		if (first_frame)
+		{
+			NTX_PERF_END(NTX_PHASE_OPEN, t_open);
+			first_frame = false;
+		}
 	}
 
 	if (layout)
 		tex_free(layout);
-	free(text);
+	NTX_TRACE_EV(NTX_EV_CLOSE, note->note_id, chunk_index);
+	return jump;
 }
 
-int main(void)
+/* Allocates the chunk text buffer for the largest chunk in the pack and checks
+ * that the largest layout the packer measured still fits, so opening a chunk
+ * never allocates on the viewer's side and fails up front rather than midway
+ * through a session. */
+static bool alloc_view_buffers(const NtxIndex* idx, char** out_text, uint16_t* out_cap)
 {
-	gfx_Begin();
-	gfx_SetDrawBuffer();
-	setup_menu_palette();
+#ifdef NTX_EMBEDDED
+	/* Compiled-in chunks are NUL-terminated and formatted in place. */
+	const uint16_t cap = 0;
+	char* text = NULL;
+#else
+	const uint16_t cap = (uint16_t)(idx->max_chunk_len + 1U);
+	char* text = (char*)NTX_MALLOC(cap, NTX_MEM_CHUNK);
+	if (!text)
+	{
+		NTX_TRACE_OOM(NTX_OOM_CHUNK_TEXT, cap);
+		return false;
+	}
+#endif
+	if (idx->max_layout_bytes)
+	{
+		void* probe = malloc((size_t)idx->max_layout_bytes);
+		if (!probe)
+		{
+			NTX_FREE(text);
+			NTX_TRACE_OOM(NTX_OOM_LAYOUT, idx->max_layout_bytes);
+			return false;
+		}
+		free(probe);
+	}
+	*out_text = text;
+	*out_cap = cap;
+	return true;
+}
+
+/* Shows up to two lines and waits for CLEAR. */
+static void show_message(const char* title, const char* detail)
+{
+	gfx_FillScreen(COL_BG);
 	gfx_SetTextFGColor(COL_FG);
-	gfx_SetTextBGColor(COL_BG);
-	fontlib_SetTransparency(true);
+	gfx_SetTextXY(4, 10);
+	gfx_PrintString(title);
+	gfx_SetTextXY(4, 24);
+	gfx_PrintString(detail);
+	gfx_SetTextXY(4, 40);
+	gfx_PrintString("Press CLEAR");
+	gfx_SwapDraw();
+	while (!(kb_Data[6] & kb_Clear))
+		kb_Scan();
+	wait_for_nav_key_release();
+}
 
-	fontlib_font_t* font_main = NULL;
-	fontlib_font_t* font_script = NULL;
-	if (!require_fontpacks(&font_main, &font_script))
+static void draw_pack_picker(const NtxPackInfo* packs, uint8_t count, int sel)
+{
+	gfx_FillScreen(UI_COL_BG);
+
+	gfx_SetColor(UI_COL_HEADER);
+	gfx_FillRectangle_NoClip(0, 0, GFX_LCD_WIDTH, 20);
+	gfx_SetTextFGColor(255);
+	gfx_SetTextXY(6, 6);
+	gfx_PrintString("notes_viewer");
+
+	char hdr[48];
+	snprintf(hdr, sizeof(hdr), "packs:%u", (unsigned)count);
+	int hdr_w = (int)gfx_GetStringWidth(hdr);
+	gfx_SetTextXY(GFX_LCD_WIDTH - hdr_w - 6, 6);
+	gfx_PrintString(hdr);
+
+	gfx_SetColor(UI_COL_PANEL);
+	gfx_FillRectangle_NoClip(0, GFX_LCD_HEIGHT - 12, GFX_LCD_WIDTH, 12);
+	gfx_SetTextFGColor(COL_FG);
+	gfx_SetTextXY(6, GFX_LCD_HEIGHT - 10);
+	gfx_PrintString("UP/DOWN:Move ENTER:Open CLEAR:Exit");
+
+	const int list_x = 4;
+	const int row_h = 18;
+	const int list_w = GFX_LCD_WIDTH - 12;
+	int y = 24;
+	for (int i = 0; i < count; ++i)
 	{
-		gfx_End();
-		return 1;
+		const bool is_sel = (i == sel);
+		gfx_SetColor(is_sel ? UI_COL_SEL : UI_COL_PANEL);
+		gfx_FillRectangle(list_x, y, list_w, row_h - 2);
+		gfx_SetColor(is_sel ? UI_COL_ACCENT : UI_COL_BORDER);
+		gfx_Rectangle(list_x, y, list_w, row_h - 2);
+
+		char rhs[20];
+		snprintf(rhs, sizeof(rhs), "%u notes", (unsigned)packs[i].note_count);
+		const int rhs_w = (int)gfx_GetStringWidth(rhs);
+
+		gfx_SetTextFGColor(COL_FG);
+		gfx_SetTextXY(list_x + 4, y + 5);
+		gfx_PrintString(packs[i].prefix);
+		gfx_SetTextXY(list_x + list_w - rhs_w - 6, y + 5);
+		gfx_PrintString(rhs);
+		y += row_h;
 	}
-	tex_draw_set_fonts(font_main, font_script);
-	TeX_Renderer* renderer = tex_renderer_create_sized(RENDERER_SLAB_SIZE);
-	if (!renderer)
+
+	NTX_HUD_DRAW_MENU();
+	gfx_SwapDraw();
+}
+
+/* Returns the chosen pack, or -1 when the user leaves with CLEAR. */
+static int pick_pack(const NtxPackInfo* packs, uint8_t count, int sel)
+{
+	bool prev_up = false;
+	bool prev_down = false;
+	bool prev_enter = false;
+	bool prev_clear = false;
+
+	while (true)
 	{
-		gfx_FillScreen(COL_BG);
-		gfx_SetTextFGColor(COL_FG);
-		gfx_SetTextXY(4, 10);
-		gfx_PrintString("TeX renderer OOM");
-		gfx_SetTextXY(4, 24);
-		gfx_PrintString("Need more free RAM");
-		gfx_SetTextXY(4, 40);
-		gfx_PrintString("Press CLEAR");
-		gfx_SwapDraw();
-		while (!(kb_Data[6] & kb_Clear))
-			kb_Scan();
-		gfx_End();
-		return 1;
+		draw_pack_picker(packs, count, sel);
+		kb_Scan();
+
+		bool now_up = (kb_Data[7] & kb_Up) != 0;
+		bool now_down = (kb_Data[7] & kb_Down) != 0;
+		bool now_enter = (kb_Data[6] & kb_Enter) != 0;
+		bool now_clear = (kb_Data[6] & kb_Clear) != 0;
+		NTX_HUD_POLL();
+
+		bool up_press = now_up && !prev_up;
+		bool down_press = now_down && !prev_down;
+		bool enter_press = now_enter && !prev_enter;
+		bool clear_press = now_clear && !prev_clear;
+
+		prev_up = now_up;
+		prev_down = now_down;
+		prev_enter = now_enter;
+		prev_clear = now_clear;
+
+		if (clear_press)
+			return -1;
+		if (up_press && sel > 0)
+			sel--;
+		if (down_press && sel < (int)count - 1)
+			sel++;
+		if (enter_press)
+		{
+			wait_for_nav_key_release();
+			return sel;
+		}
 	}
+}
 
+/* Loads one pack's index, menu and buffers, runs its chunk menu until CLEAR
+ * and frees everything again, so only the open pack costs memory. Returns
+ * false when the pack could not be opened. */
+static bool run_pack(const char* index_name, TeX_Renderer* renderer, bool from_picker)
+{
 	NtxIndex idx;
 	char err[64] = { 0 };
-	if (!ntx_load_index(&idx, err, sizeof(err)))
+	NTX_PERF_START(t_index);
+	NTX_TRACE_BEGIN(t_trace_index);
+	const bool index_ok = ntx_load_index(index_name, &idx, err, sizeof(err));
+	NTX_PERF_END(NTX_PHASE_INDEX_LOAD, t_index);
+	NTX_TRACE_SPAN(NTX_EV_INDEX_LOAD, idx.count, index_ok, t_trace_index);
+	if (!index_ok)
 	{
-		gfx_FillScreen(COL_BG);
-		gfx_SetTextXY(4, 10);
-		gfx_PrintString("NTXIDX load failed");
-		gfx_SetTextXY(4, 24);
-		gfx_PrintString(err);
-		gfx_SetTextXY(4, 40);
-		gfx_PrintString("Press CLEAR");
-		gfx_SwapDraw();
-		while (!(kb_Data[6] & kb_Clear))
-			kb_Scan();
-		gfx_End();
-		return 1;
+		char title[32];
+		snprintf(title, sizeof(title), "%s load failed", index_name);
+		show_message(title, err);
+		return false;
 	}
 
-	ChunkMenuItem* items = NULL;
-	uint16_t item_count = 0;
-	if (!build_chunk_menu(&idx, &items, &item_count))
+	char* text_buf = NULL;
+	uint16_t text_cap = 0;
+	if (!alloc_view_buffers(&idx, &text_buf, &text_cap))
 	{
 		ntx_free_index(&idx);
-		gfx_End();
-		return 1;
+		show_message("Chunk buffers OOM", "Need more free RAM");
+		return false;
 	}
 
-	int sel = 0;
+	ChunkMenuItem cursor;
+	NTX_PERF_START(t_menu);
+	const uint32_t item_count = menu_first(&idx, &cursor) ? idx.total_chunks : 0;
+	NTX_PERF_END(NTX_PHASE_MENU_BUILD, t_menu);
+	NTX_HUD_SAMPLE_HEAP();
+	NTX_TRACE_EV(NTX_EV_SESSION, idx.count, item_count);
+
+	uint32_t sel = 0;
 	bool prev_up = false;
 	bool prev_down = false;
 	bool prev_enter = false;
@@ -442,13 +707,16 @@ int main(void)
 
 	while (true)
 	{
-		draw_chunk_menu(&idx, items, item_count, sel);
+		NTX_PERF_START(t_menu_frame);
+		draw_chunk_menu(&idx, (item_count > 0) ? &cursor : NULL, item_count, sel, from_picker);
+		NTX_PERF_END(NTX_PHASE_MENU_FRAME, t_menu_frame);
 		kb_Scan();
 
 		bool now_up = (kb_Data[7] & kb_Up) != 0;
 		bool now_down = (kb_Data[7] & kb_Down) != 0;
 		bool now_enter = (kb_Data[6] & kb_Enter) != 0;
 		bool now_clear = (kb_Data[6] & kb_Clear) != 0;
+		NTX_HUD_POLL();
 
 		bool up_press = now_up && !prev_up;
 		bool down_press = now_down && !prev_down;
@@ -462,16 +730,25 @@ int main(void)
 
 		if (clear_press)
 			break;
-		if (up_press && sel > 0)
+		if (up_press && sel > 0 && menu_step(&idx, &cursor, false))
 			sel--;
-		if (down_press && sel < (int)item_count - 1)
+		if (down_press && sel + 1 < item_count && menu_step(&idx, &cursor, true))
 			sel++;
 		if (enter_press && item_count > 0)
 		{
-			const ChunkMenuItem* mi = &items[sel];
-			const NtxNoteEntry* note = &idx.entries[mi->note_index];
-			view_chunk_tex(note, mi->chunk_index, renderer);
+			const NtxNoteEntry* note = ntx_index_note(&idx, cursor.note_index, err, sizeof(err));
+			NTX_PERF_TAG(sel);
+			uint32_t chunk = cursor.chunk_index;
+			int scroll = 0;
+			if (note)
+			{
+				while (view_chunk_tex(&idx, note, &chunk, &scroll, renderer, text_buf, text_cap))
+					;
+			}
+			else
+				show_message("Index shard failed", err);
 			wait_for_nav_key_release();
+			NTX_HUD_SAMPLE_HEAP();
 
 			prev_up = false;
 			prev_down = false;
@@ -480,9 +757,70 @@ int main(void)
 		}
 	}
 
-	free(items);
+	NTX_FREE(text_buf);
 	ntx_free_index(&idx);
+	if (from_picker)
+		wait_for_nav_key_release();
+	return true;
+}
+
+int main(void)
+{
+	gfx_Begin();
+	gfx_SetDrawBuffer();
+	setup_menu_palette();
+	gfx_SetTextFGColor(COL_FG);
+	gfx_SetTextBGColor(COL_BG);
+	fontlib_SetTransparency(true);
+	NTX_PERF_INIT();
+	NTX_TRACE_INIT();
+	NTX_HUD_INIT(RENDERER_SLAB_SIZE);
+
+	fontlib_font_t* font_main = NULL;
+	fontlib_font_t* font_script = NULL;
+	if (!require_fontpacks(&font_main, &font_script))
+	{
+		NTX_TRACE_FLUSH();
+		gfx_End();
+		return 1;
+	}
+	tex_draw_set_fonts(font_main, font_script);
+	TeX_Renderer* renderer = tex_renderer_create_sized(RENDERER_SLAB_SIZE);
+	if (!renderer)
+	{
+		NTX_TRACE_OOM(NTX_OOM_RENDERER, RENDERER_SLAB_SIZE);
+		show_message("TeX renderer OOM", "Need more free RAM");
+		NTX_TRACE_FLUSH();
+		gfx_End();
+		return 1;
+	}
+	NTX_MEM_ACCOUNT(NTX_MEM_RENDERER, RENDERER_SLAB_SIZE, true);
+
+	/* Only index headers are read here; a pack's notes load once it is chosen. */
+	NtxPackInfo packs[MAX_PACKS];
+	const uint8_t pack_count = ntx_find_packs(packs, MAX_PACKS);
+	int status = 0;
+	if (pack_count == 0)
+	{
+		show_message("No notes pack found", "Send NOTES_BUNDLE.8xg");
+		status = 1;
+	}
+	else if (pack_count == 1)
+	{
+		if (!run_pack(packs[0].index_name, renderer, false))
+			status = 1;
+	}
+	else
+	{
+		int sel = 0;
+		while ((sel = pick_pack(packs, pack_count, sel)) >= 0)
+			run_pack(packs[sel].index_name, renderer, true);
+	}
+
+	NTX_PERF_FLUSH();
 	tex_renderer_destroy(renderer);
+	NTX_MEM_ACCOUNT(NTX_MEM_RENDERER, RENDERER_SLAB_SIZE, false);
+	NTX_TRACE_FLUSH();
 	gfx_End();
-	return 0;
+	return status;
 }
@@ -0,0 +1,134 @@
+#include "ntx_hud.h"
+
+#ifdef NTX_HUD
+
+#include "ntx_mem.h"
+#include "ntx_perf.h"
+
+#include <graphx.h>
+#include <keypadc.h>
+#include <stdio.h>
+
+/* Entries of the menu palette set up in main.c. */
+#define HUD_COL_PANEL 250
+#define HUD_COL_TEXT 252
+
+#define HUD_LINE_H 10
+#define HUD_PAD 2
+#define HUD_LINE_LEN 40
+#define HUD_CYCLES_PER_TENTH_MS (NTX_PERF_CLOCK_HZ / 10000UL)
+
+static bool s_visible;
+static bool s_prev_mode;
+static size_t s_slab_size;
+static size_t s_heap_free;
+
+void ntx_hud_init(size_t slab_size)
+{
+	s_visible = false;
+	s_prev_mode = false;
+	s_slab_size = slab_size;
+	s_heap_free = 0;
+}
+
+/* Only run on demand, never per frame: see ntx_mem_largest_free. */
+void ntx_hud_sample_heap(void)
+{
+	s_heap_free = ntx_mem_largest_free();
+}
+
+void ntx_hud_poll(void)
+{
+	const bool now_mode = (kb_Data[1] & kb_Mode) != 0;
+	if (now_mode && !s_prev_mode)
+	{
+		s_visible = !s_visible;
+		if (s_visible)
+			ntx_hud_sample_heap();
+	}
+	s_prev_mode = now_mode;
+}
+
+static void format_ms(char* out, size_t out_len, const char* label, NtxPerfPhase phase)
+{
+	const unsigned long tenths = (unsigned long)(ntx_perf_last(phase) / HUD_CYCLES_PER_TENTH_MS);
+	snprintf(out, out_len, "%s %lu.%lu", label, tenths / 10UL, tenths % 10UL);
+}
+
+static void draw_panel(int y, char lines[][HUD_LINE_LEN], int count)
+{
+	int w = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const int lw = (int)gfx_GetStringWidth(lines[i]);
+		if (lw > w)
+			w = lw;
+	}
+	const int x = GFX_LCD_WIDTH - w - (HUD_PAD * 2) - 2;
+	gfx_SetColor(HUD_COL_PANEL);
+	gfx_FillRectangle(x, y, w + (HUD_PAD * 2), (count * HUD_LINE_H) + HUD_PAD);
+	gfx_SetTextFGColor(HUD_COL_TEXT);
+	for (int i = 0; i < count; ++i)
+	{
+		gfx_SetTextXY(x + HUD_PAD, y + HUD_PAD + (i * HUD_LINE_H));
+		gfx_PrintString(lines[i]);
+	}
+}
+
+static void format_heap(char* out, size_t out_len)
+{
+	snprintf(out, out_len, "heap %u slab %u", (unsigned int)s_heap_free, (unsigned int)s_slab_size);
+}
+
+#ifdef NTX_MEM_TRACK
+#define HUD_MEM_LINES 1
+
+static void format_tracked(char* out, size_t out_len)
+{
+	NtxMemStats st;
+	ntx_mem_stats(&st);
+	snprintf(out, out_len, "live %u hw %u", (unsigned int)st.live_total, (unsigned int)st.high_water);
+}
+#else
+#define HUD_MEM_LINES 0
+#endif
+
+void ntx_hud_draw_menu(void)
+{
+	if (!s_visible)
+		return;
+	char a[16];
+	char b[16];
+	char lines[2 + HUD_MEM_LINES][HUD_LINE_LEN];
+	format_ms(a, sizeof(a), "idx", NTX_PHASE_INDEX_LOAD);
+	format_ms(b, sizeof(b), "frame", NTX_PHASE_MENU_FRAME);
+	snprintf(lines[0], sizeof(lines[0]), "%s %s ms", a, b);
+	format_heap(lines[1], sizeof(lines[1]));
+#ifdef NTX_MEM_TRACK
+	format_tracked(lines[2], sizeof(lines[2]));
+#endif
+	const int count = 2 + HUD_MEM_LINES;
+	draw_panel(GFX_LCD_HEIGHT - 14 - (count * HUD_LINE_H) - HUD_PAD, lines, count);
+}
+
+void ntx_hud_draw_view(void)
+{
+	if (!s_visible)
+		return;
+	char a[16];
+	char b[16];
+	char lines[3 + HUD_MEM_LINES][HUD_LINE_LEN];
+	format_ms(a, sizeof(a), "load", NTX_PHASE_CHUNK_LOAD);
+	format_ms(b, sizeof(b), "fmt", NTX_PHASE_FORMAT);
+	snprintf(lines[0], sizeof(lines[0]), "%s %s ms", a, b);
+	format_ms(a, sizeof(a), "draw", NTX_PHASE_TEX_DRAW);
+	format_ms(b, sizeof(b), "swap", NTX_PHASE_SWAP);
+	snprintf(lines[1], sizeof(lines[1]), "%s %s ms", a, b);
+	format_heap(lines[2], sizeof(lines[2]));
+#ifdef NTX_MEM_TRACK
+	format_tracked(lines[3], sizeof(lines[3]));
+#endif
+	draw_panel(14, lines, 3 + HUD_MEM_LINES);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "ntx_mem.h"
+
+#include <string.h>
+
+#define NTX_MEM_PROBE_MAX ((size_t)65535)
+
+static const char* const s_tag_names[NTX_MEM_TAG_COUNT] = {
+	"index", "title", "chunk", "renderer",
+};
+
+const char* ntx_mem_tag_name(NtxMemTag tag)
+{
+	return ((unsigned)tag < NTX_MEM_TAG_COUNT) ? s_tag_names[tag] : "?";
+}
+
+/* There is no heap query on the CE. */
+size_t ntx_mem_largest_free(void)
+{
+	size_t lo = 0;
+	size_t hi = NTX_MEM_PROBE_MAX;
+	while (lo < hi)
+	{
+		const size_t mid = lo + ((hi - lo + 1U) / 2U);
+		void* p = malloc(mid);
+		if (p)
+		{
+			free(p);
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1U;
+		}
+	}
+	return lo;
+}
+
+#ifdef NTX_MEM_TRACK
+
+typedef union
+{
+	struct
+	{
+		size_t size;
+		uint8_t tag;
+	} h;
+	max_align_t align;
+} MemHeader;
+
+static NtxMemStats s_stats;
+
+static void track_add(NtxMemTag tag, size_t size)
+{
+	s_stats.live[tag] += size;
+	if (s_stats.live[tag] > s_stats.peak[tag])
+		s_stats.peak[tag] = s_stats.live[tag];
+	s_stats.live_total += size;
+	if (s_stats.live_total > s_stats.high_water)
+		s_stats.high_water = s_stats.live_total;
+}
+
+static void track_remove(NtxMemTag tag, size_t size)
+{
+	s_stats.live[tag] -= size;
+	s_stats.live_total -= size;
+}
+
+void* ntx_mem_alloc(size_t size, NtxMemTag tag)
+{
+	if ((unsigned)tag >= NTX_MEM_TAG_COUNT || size > (size_t)-1 - sizeof(MemHeader))
+		return NULL;
+	MemHeader* hdr = (MemHeader*)malloc(sizeof(MemHeader) + size);
+	if (!hdr)
+	{
+		s_stats.failures++;
+		return NULL;
+	}
+	hdr->h.size = size;
+	hdr->h.tag = (uint8_t)tag;
+	s_stats.allocs++;
+	track_add(tag, size);
+	return hdr + 1;
+}
+
+void* ntx_mem_calloc(size_t count, size_t size, NtxMemTag tag)
+{
+	if (size && count > (size_t)-1 / size)
+		return NULL;
+	void* p = ntx_mem_alloc(count * size, tag);
+	if (p)
+		memset(p, 0, count * size);
+	return p;
+}
+
+void ntx_mem_free(void* ptr)
+{
+	if (!ptr)
+		return;
+	MemHeader* hdr = (MemHeader*)ptr - 1;
+	track_remove((NtxMemTag)hdr->h.tag, hdr->h.size);
+	free(hdr);
+}
+
+void ntx_mem_account(NtxMemTag tag, size_t size, bool add)
+{
+	if ((unsigned)tag >= NTX_MEM_TAG_COUNT)
+		return;
+	if (add)
+		track_add(tag, size);
+	else
+		track_remove(tag, size);
+}
+
+void ntx_mem_stats(NtxMemStats* out)
+{
+	if (out)
+		*out = s_stats;
+}
+
+#endif
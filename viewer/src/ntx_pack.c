@@ -1,16 +1,39 @@
+#include "ntx_mem.h"
 #include "ntx_pack.h"
+#include "ntx_trace.h"
+#ifdef NTX_EMBEDDED
+#include "ntx_embed.h"
+#endif
 
 #include <fileioc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define NTX_INDEX_NAME "NTXIDX"
 #define NTX_MAGIC_IDX "NTXI"
+#define NTX_MAGIC_SHARD "NTXS"
 #define NTX_MAGIC_PART "NTXP"
-
-#define NTX_PART_HEADER_SIZE 24U
+#define NTX_MAGIC_DICT "NTXD"
+
+#define NTX_INDEX_VERSION 5U
+#define NTX_INDEX_HEADER_SIZE 26U
+#define NTX_ROOT_SHARD_SIZE 8U
+#define NTX_SHARD_VERSION 1U
+#define NTX_SHARD_HEADER_SIZE 12U
+#define NTX_INDEX_ENTRY_SIZE 16U
+#define NTX_PART_VERSION 3U
+#define NTX_PART_HEADER_SIZE 28U
 #define NTX_PART_ENTRY_SIZE 8U
+#define NTX_DICT_VERSION 2U
+#define NTX_DICT_HEADER_SIZE 16U
+#define NTX_DICT_ENTRY_SIZE 4U
+/* Chunk codes naming dictionary entries, in bytes text never contains: a byte
+ * in 0x03..0x1F other than tab, LF and CR is token 0..25; NTX_DICT_TOKEN then
+ * n (1..255) is token 25 + n; NTX_DICT_REF then the id as two 7-bit bytes
+ * with the high bit set is any entry (shared blocks). */
+#define NTX_DICT_REF 0x01U
+#define NTX_DICT_TOKEN 0x02U
+#define NTX_DICT_SHORT_CODES 26U
 
 static void set_err(char* err, size_t err_len, const char* msg)
 {
@@ -36,6 +59,37 @@ static uint32_t read_u32_le(const uint8_t* p)
 	return (uint32_t)p[0] | ((uint32_t)p[1] << 8U) | ((uint32_t)p[2] << 16U) | ((uint32_t)p[3] << 24U);
 }
 
+#ifdef NTX_EMBEDDED
+
+/* The compiled-in index and shards are parsed in place. */
+static bool acquire_index(const char* name, const uint8_t** out_buf, uint16_t* out_len, char* err, size_t err_len)
+{
+	(void)name;
+	(void)err;
+	(void)err_len;
+	*out_buf = ntx_embed_index.data;
+	*out_len = ntx_embed_index.size;
+	return true;
+}
+
+static bool acquire_shard(uint16_t shard, const char* name, const uint8_t** out_buf, uint16_t* out_len, char* err,
+                          size_t err_len)
+{
+	(void)name;
+	(void)err;
+	(void)err_len;
+	*out_buf = ntx_embed_shards[shard].data;
+	*out_len = ntx_embed_shards[shard].size;
+	return true;
+}
+
+static void release_index(const uint8_t* buf)
+{
+	(void)buf;
+}
+
+#else
+
 static bool read_appvar_bytes(const char* name, uint8_t** out_buf, uint16_t* out_len, char* err, size_t err_len)
 {
 	if (!out_buf || !out_len)
@@ -58,10 +112,11 @@ static bool read_appvar_bytes(const char* name, uint8_t** out_buf, uint16_t* out
 		return false;
 	}
 
-	uint8_t* buf = (uint8_t*)malloc(sz);
+	uint8_t* buf = (uint8_t*)NTX_MALLOC(sz, NTX_MEM_INDEX);
 	if (!buf)
 	{
 		ti_Close(h);
+		NTX_TRACE_OOM(NTX_OOM_APPVAR_BUF, sz);
 		set_err_name(err, err_len, "oom reading ", name);
 		return false;
 	}
@@ -72,7 +127,7 @@ static bool read_appvar_bytes(const char* name, uint8_t** out_buf, uint16_t* out
 
 	if (got != sz)
 	{
-		free(buf);
+		NTX_FREE(buf);
 		set_err_name(err, err_len, "short read: ", name);
 		return false;
 	}
@@ -82,92 +137,305 @@ static bool read_appvar_bytes(const char* name, uint8_t** out_buf, uint16_t* out
 	return true;
 }
 
-bool ntx_load_index(NtxIndex* out, char* err, size_t err_len)
+static bool acquire_index(const char* name, const uint8_t** out_buf, uint16_t* out_len, char* err, size_t err_len)
+{
+	uint8_t* buf = NULL;
+	if (!read_appvar_bytes(name, &buf, out_len, err, err_len))
+		return false;
+	*out_buf = buf;
+	return true;
+}
+
+static bool acquire_shard(uint16_t shard, const char* name, const uint8_t** out_buf, uint16_t* out_len, char* err,
+                          size_t err_len)
+{
+	(void)shard;
+	return acquire_index(name, out_buf, out_len, err, err_len);
+}
+
+static void release_index(const uint8_t* buf)
+{
+	NTX_FREE((void*)buf);
+}
+
+#endif
+
+static bool index_header_ok(const uint8_t* hdr)
+{
+	return read_u16_le(hdr + 4) == NTX_INDEX_VERSION && read_u16_le(hdr + 6) == NTX_INDEX_HEADER_SIZE;
+}
+
+/* The prefix sits NUL-padded in what was a reserved field; zero means NTX. */
+static void read_prefix(const uint8_t* hdr, char out[NTX_PREFIX_MAX + 1])
+{
+	size_t n = 0;
+	while (n < NTX_PREFIX_MAX && hdr[12 + n] != 0)
+	{
+		out[n] = (char)hdr[12 + n];
+		n++;
+	}
+	out[n] = '\0';
+	if (n == 0)
+		memcpy(out, "NTX", 4);
+}
+
+static void add_pack(NtxPackInfo* out, uint8_t count, const char* name, const uint8_t* hdr)
+{
+	NtxPackInfo info;
+	snprintf(info.index_name, sizeof(info.index_name), "%s", name);
+	read_prefix(hdr, info.prefix);
+	info.note_count = read_u16_le(hdr + 8);
+
+	/* Sorted by prefix so the picker order does not follow the VAT. */
+	uint8_t i = count;
+	while (i > 0 && strcmp(out[i - 1].prefix, info.prefix) > 0)
+	{
+		out[i] = out[i - 1];
+		i--;
+	}
+	out[i] = info;
+}
+
+#ifdef NTX_EMBEDDED
+
+uint8_t ntx_find_packs(NtxPackInfo* out, uint8_t max)
+{
+	if (!out || max == 0 || ntx_embed_index.size < NTX_INDEX_HEADER_SIZE)
+		return 0;
+	add_pack(out, 0, NTX_DEFAULT_INDEX, ntx_embed_index.data);
+	return 1;
+}
+
+#else
+
+uint8_t ntx_find_packs(NtxPackInfo* out, uint8_t max)
 {
 	if (!out)
+		return 0;
+	uint8_t count = 0;
+	void* pos = NULL;
+	const char* name;
+	while (count < max && (name = ti_Detect(&pos, NTX_MAGIC_IDX)) != NULL)
+	{
+		uint8_t hdr[NTX_INDEX_HEADER_SIZE];
+		uint8_t h = ti_Open(name, "r");
+		if (!h)
+			continue;
+		const bool ok = ti_Read(hdr, 1, sizeof(hdr), h) == sizeof(hdr) && index_header_ok(hdr);
+		ti_Close(h);
+		if (!ok)
+			continue;
+		add_pack(out, count, name, hdr);
+		count++;
+	}
+	return count;
+}
+
+#endif
+
+bool ntx_load_index(const char* index_name, NtxIndex* out, char* err, size_t err_len)
+{
+	if (!out || !index_name)
 		return false;
 	memset(out, 0, sizeof(*out));
+	for (uint8_t i = 0; i < NTX_SHARD_SLOTS; ++i)
+		out->slots[i].shard = NTX_SHARD_NONE;
 
-	uint8_t* buf = NULL;
+	const uint8_t* buf = NULL;
 	uint16_t len = 0;
-	if (!read_appvar_bytes(NTX_INDEX_NAME, &buf, &len, err, err_len))
+	if (!acquire_index(index_name, &buf, &len, err, err_len))
 		return false;
 
-	if (len < 16)
+	if (len < NTX_INDEX_HEADER_SIZE)
 	{
-		free(buf);
+		release_index(buf);
 		set_err(err, err_len, "index too small");
 		return false;
 	}
 
 	if (memcmp(buf, NTX_MAGIC_IDX, 4) != 0)
 	{
-		free(buf);
+		release_index(buf);
 		set_err(err, err_len, "bad index magic");
 		return false;
 	}
 
-	uint16_t version = read_u16_le(buf + 4);
-	uint16_t hdr_size = read_u16_le(buf + 6);
 	uint16_t note_count = read_u16_le(buf + 8);
+	uint16_t shard_count = read_u16_le(buf + 10);
 
-	if (version != 1 || hdr_size != 16)
+	if (!index_header_ok(buf))
 	{
-		free(buf);
+		release_index(buf);
 		set_err(err, err_len, "index version mismatch");
 		return false;
 	}
+	read_prefix(buf, out->prefix);
+	out->max_chunk_len = read_u16_le(buf + 16);
+	out->max_part_size = read_u16_le(buf + 18);
+	out->max_layout_bytes = read_u32_le(buf + 20);
+	out->dict_count = read_u16_le(buf + 24);
 
-	if (note_count == 0)
+	if (shard_count == 0)
 	{
-		free(buf);
+		release_index(buf);
+		if (note_count != 0)
+		{
+			set_err(err, err_len, "index has no shards");
+			return false;
+		}
 		return true;
 	}
+	if ((size_t)NTX_INDEX_HEADER_SIZE + ((size_t)shard_count * NTX_ROOT_SHARD_SIZE) > len)
+	{
+		release_index(buf);
+		set_err(err, err_len, "truncated index");
+		return false;
+	}
+
+	NtxShardInfo* shards = (NtxShardInfo*)NTX_CALLOC(shard_count, sizeof(NtxShardInfo), NTX_MEM_INDEX);
+	if (!shards)
+	{
+		release_index(buf);
+		NTX_TRACE_OOM(NTX_OOM_INDEX_ENTRIES, (size_t)shard_count * sizeof(NtxShardInfo));
+		set_err(err, err_len, "oom shards");
+		return false;
+	}
 
-	NtxNoteEntry* entries = (NtxNoteEntry*)calloc(note_count, sizeof(NtxNoteEntry));
+	/* Shards must cover the notes in order, so ntx_index_note can bisect. */
+	uint32_t next_note = 0;
+	uint32_t total_chunks = 0;
+	const uint8_t* rec = buf + NTX_INDEX_HEADER_SIZE;
+	uint16_t i = 0;
+	for (; i < shard_count; ++i, rec += NTX_ROOT_SHARD_SIZE)
+	{
+		shards[i].first_note = read_u16_le(rec + 0);
+		shards[i].note_count = read_u16_le(rec + 2);
+		shards[i].total_chunks = read_u32_le(rec + 4);
+		if (shards[i].first_note != next_note || shards[i].note_count == 0)
+			break;
+		next_note += shards[i].note_count;
+		total_chunks += shards[i].total_chunks;
+	}
+	release_index(buf);
+	if (i != shard_count || next_note != note_count)
+	{
+		NTX_FREE(shards);
+		set_err(err, err_len, "bad shard table");
+		return false;
+	}
+
+	out->count = note_count;
+	out->shard_count = shard_count;
+	out->total_chunks = total_chunks;
+	out->shards = shards;
+	return true;
+}
+
+static void free_entries(NtxNoteEntry* entries, uint16_t count)
+{
+	for (uint16_t i = 0; i < count; ++i)
+		NTX_FREE(entries[i].title);
+	NTX_FREE(entries);
+}
+
+static void free_slot(NtxShardSlot* slot)
+{
+	if (slot->entries)
+		free_entries(slot->entries, slot->count);
+	slot->entries = NULL;
+	slot->count = 0;
+	slot->shard = NTX_SHARD_NONE;
+}
+
+void ntx_free_index(NtxIndex* index)
+{
+	if (!index)
+		return;
+	for (uint8_t i = 0; i < NTX_SHARD_SLOTS; ++i)
+		free_slot(&index->slots[i]);
+	NTX_FREE(index->shards);
+	index->shards = NULL;
+	index->shard_count = 0;
+	index->count = 0;
+}
+
+/* Shard N is <prefix>S plus N in three base-36 digits. */
+static void shard_name(const char* prefix, uint16_t shard, char out_name[9])
+{
+	static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	size_t n = 0;
+	while (n < NTX_PREFIX_MAX && prefix[n])
+	{
+		out_name[n] = prefix[n];
+		n++;
+	}
+	out_name[n++] = 'S';
+	for (size_t d = 3; d-- > 0;)
+	{
+		out_name[n + d] = digits[shard % 36U];
+		shard = (uint16_t)(shard / 36U);
+	}
+	out_name[n + 3] = '\0';
+}
+
+static bool parse_shard(const uint8_t* buf, uint16_t len, const NtxShardInfo* info, NtxShardSlot* slot, char* err,
+                        size_t err_len)
+{
+	if (len < NTX_SHARD_HEADER_SIZE || memcmp(buf, NTX_MAGIC_SHARD, 4) != 0)
+	{
+		set_err(err, err_len, "bad shard header");
+		return false;
+	}
+	if (read_u16_le(buf + 4) != NTX_SHARD_VERSION || read_u16_le(buf + 6) != NTX_SHARD_HEADER_SIZE)
+	{
+		set_err(err, err_len, "shard version mismatch");
+		return false;
+	}
+	if (read_u16_le(buf + 8) != info->first_note || read_u16_le(buf + 10) != info->note_count)
+	{
+		set_err(err, err_len, "shard does not match index");
+		return false;
+	}
+
+	const uint16_t note_count = info->note_count;
+	NtxNoteEntry* entries = (NtxNoteEntry*)NTX_CALLOC(note_count, sizeof(NtxNoteEntry), NTX_MEM_INDEX);
 	if (!entries)
 	{
-		free(buf);
+		NTX_TRACE_OOM(NTX_OOM_INDEX_ENTRIES, (size_t)note_count * sizeof(NtxNoteEntry));
 		set_err(err, err_len, "oom entries");
 		return false;
 	}
 
-	size_t pos = hdr_size;
+	size_t pos = NTX_SHARD_HEADER_SIZE;
 	for (uint16_t i = 0; i < note_count; ++i)
 	{
-		if (pos + 14 > len)
+		if (pos + NTX_INDEX_ENTRY_SIZE > len)
 		{
-			free(entries);
-			free(buf);
-			set_err(err, err_len, "truncated index");
+			free_entries(entries, i);
+			set_err(err, err_len, "truncated shard");
 			return false;
 		}
 
 		entries[i].note_id = read_u16_le(buf + pos + 0);
 		entries[i].first_part_id = read_u16_le(buf + pos + 2);
 		entries[i].part_count = read_u16_le(buf + pos + 4);
-		entries[i].total_chunks = read_u16_le(buf + pos + 6);
-		entries[i].total_text_bytes = read_u32_le(buf + pos + 8);
-		uint8_t title_len = buf[pos + 12];
-		pos += 14;
+		entries[i].total_chunks = read_u32_le(buf + pos + 6);
+		entries[i].total_text_bytes = read_u32_le(buf + pos + 10);
+		uint8_t title_len = buf[pos + 14];
+		pos += NTX_INDEX_ENTRY_SIZE;
 
 		if (pos + title_len > len)
 		{
-			for (uint16_t j = 0; j < i; ++j)
-				free(entries[j].title);
-			free(entries);
-			free(buf);
+			free_entries(entries, i);
 			set_err(err, err_len, "truncated title");
 			return false;
 		}
 
-		entries[i].title = (char*)malloc((size_t)title_len + 1U);
+		entries[i].title = (char*)NTX_MALLOC((size_t)title_len + 1U, NTX_MEM_TITLE);
 		if (!entries[i].title)
 		{
-			for (uint16_t j = 0; j < i; ++j)
-				free(entries[j].title);
-			free(entries);
-			free(buf);
+			free_entries(entries, i);
+			NTX_TRACE_OOM(NTX_OOM_TITLE, (size_t)title_len + 1U);
 			set_err(err, err_len, "oom title");
 			return false;
 		}
@@ -176,44 +444,226 @@ bool ntx_load_index(NtxIndex* out, char* err, size_t err_len)
 		pos += title_len;
 	}
 
-	out->count = note_count;
-	out->entries = entries;
-	free(buf);
+	slot->count = note_count;
+	slot->entries = entries;
 	return true;
 }
 
-void ntx_free_index(NtxIndex* index)
+const NtxNoteEntry* ntx_index_note(NtxIndex* index, uint16_t note_index, char* err, size_t err_len)
 {
-	if (!index || !index->entries)
-		return;
-	for (uint16_t i = 0; i < index->count; ++i)
-		free(index->entries[i].title);
-	free(index->entries);
-	index->entries = NULL;
-	index->count = 0;
+	if (!index || note_index >= index->count)
+	{
+		set_err(err, err_len, "note out of range");
+		return NULL;
+	}
+
+	uint16_t lo = 0;
+	uint16_t hi = index->shard_count;
+	while (hi - lo > 1)
+	{
+		const uint16_t mid = (uint16_t)(lo + ((hi - lo) / 2));
+		if (index->shards[mid].first_note <= note_index)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	const NtxShardInfo* info = &index->shards[lo];
+	const uint16_t rel = (uint16_t)(note_index - info->first_note);
+
+	for (uint8_t i = 0; i < NTX_SHARD_SLOTS; ++i)
+	{
+		if (index->slots[i].shard == lo)
+		{
+			index->last_slot = i;
+			return &index->slots[i].entries[rel];
+		}
+	}
+
+	/* Miss: replace the slot that was not used last. */
+	const uint8_t victim = (uint8_t)((index->last_slot + 1U) % NTX_SHARD_SLOTS);
+	NtxShardSlot* slot = &index->slots[victim];
+	free_slot(slot);
+
+	char name[9];
+	shard_name(index->prefix, lo, name);
+	const uint8_t* buf = NULL;
+	uint16_t len = 0;
+	NTX_TRACE_BEGIN(t_shard);
+	bool ok = acquire_shard(lo, name, &buf, &len, err, err_len);
+	if (ok)
+	{
+		ok = parse_shard(buf, len, info, slot, err, err_len);
+		release_index(buf);
+	}
+	NTX_TRACE_SPAN(NTX_EV_SHARD_LOAD, lo, ok ? slot->count : 0, t_shard);
+	if (!ok)
+		return NULL;
+
+	slot->shard = lo;
+	index->last_slot = victim;
+	return &slot->entries[rel];
 }
 
-void ntx_part_name_from_id(uint16_t id, char out_name[9])
+/* Four base-36 digits name every u16 part id (NTX0001..NTX1EKF). */
+void ntx_part_name_from_id(const char* prefix, uint16_t id, char out_name[9])
 {
+	static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 	if (!out_name)
 		return;
-	snprintf(out_name, 9, "NTX%04u", (unsigned int)id);
+	size_t n = 0;
+	if (!prefix)
+		prefix = "NTX";
+	while (n < NTX_PREFIX_MAX && prefix[n])
+	{
+		out_name[n] = prefix[n];
+		n++;
+	}
+	for (size_t d = 4; d-- > 0;)
+	{
+		out_name[n + d] = digits[id % 36U];
+		id = (uint16_t)(id / 36U);
+	}
+	out_name[n + 4] = '\0';
+}
+
+/* Parts are read in place: compiled-in ones from the program, AppVars through
+ * ti_GetDataPtr (a flash pointer when archived). An open handle keeps the
+ * pointer valid. */
+#ifdef NTX_EMBEDDED
+
+typedef const NtxEmbedVar* PartHandle;
+
+static PartHandle part_open(uint16_t part_id, const char* name)
+{
+	(void)name;
+	return (part_id >= 1 && part_id <= ntx_embed_part_count) ? &ntx_embed_parts[part_id - 1] : NULL;
+}
+
+static void part_close(PartHandle h)
+{
+	(void)h;
 }
 
-bool ntx_load_chunk_text(const NtxNoteEntry* note, uint16_t global_chunk_index, char** out_text, uint16_t* out_len,
-                         uint8_t* out_split_kind, char* err, size_t err_len)
+static uint16_t part_size(PartHandle h)
 {
-	if (!note || !out_text || !out_len)
+	return h->size;
+}
+
+static const uint8_t* part_data(PartHandle h)
+{
+	return h->data;
+}
+
+#else
+
+typedef uint8_t PartHandle;
+
+static PartHandle part_open(uint16_t part_id, const char* name)
+{
+	(void)part_id;
+	return ti_Open(name, "r");
+}
+
+static void part_close(PartHandle h)
+{
+	ti_Close(h);
+}
+
+static uint16_t part_size(PartHandle h)
+{
+	return ti_GetSize(h);
+}
+
+static const uint8_t* part_data(PartHandle h)
+{
+	return (const uint8_t*)ti_GetDataPtr(h);
+}
+
+#endif
+
+/* A validated part: its chunk table (rel u16, len u16, split kind, pad,
+ * rendered height u16 per entry) and payload. */
+typedef struct
+{
+	const uint8_t* table;
+	const uint8_t* payload;
+	uint16_t payload_size;
+	uint16_t chunk_count;
+	uint32_t first_chunk;
+} PartView;
+
+static bool part_view(PartHandle h, PartView* out, char* err, size_t err_len)
+{
+	const uint16_t size = part_size(h);
+	const uint8_t* hdr = part_data(h);
+	if (size < NTX_PART_HEADER_SIZE || !hdr || memcmp(hdr, NTX_MAGIC_PART, 4) != 0)
 	{
-		set_err(err, err_len, "bad args");
+		set_err(err, err_len, "bad part header");
 		return false;
 	}
-	*out_text = NULL;
-	*out_len = 0;
-	if (out_split_kind)
-		*out_split_kind = 0;
 
-	if (global_chunk_index >= note->total_chunks)
+	uint16_t version = read_u16_le(hdr + 4);
+	uint16_t header_size = read_u16_le(hdr + 6);
+	uint16_t chunk_count = read_u16_le(hdr + 14);
+	uint16_t chunk_table_off = read_u16_le(hdr + 16);
+	uint16_t payload_off = read_u16_le(hdr + 18);
+	uint16_t payload_size = read_u16_le(hdr + 20);
+
+	if (version != NTX_PART_VERSION || header_size != NTX_PART_HEADER_SIZE)
+	{
+		set_err(err, err_len, "part version mismatch");
+		return false;
+	}
+	if ((size_t)payload_off + payload_size > size)
+	{
+		set_err(err, err_len, "part payload out of bounds");
+		return false;
+	}
+	if ((size_t)chunk_table_off + ((size_t)chunk_count * NTX_PART_ENTRY_SIZE) > size)
+	{
+		set_err(err, err_len, "part chunk table out of bounds");
+		return false;
+	}
+	out->table = hdr + chunk_table_off;
+	out->payload = hdr + payload_off;
+	out->payload_size = payload_size;
+	out->chunk_count = chunk_count;
+	out->first_chunk = read_u32_le(hdr + 24);
+	return true;
+}
+
+/* Checks the part header and, when the chunk is in this part, points *out_src
+ * at its stored bytes. Returns 1 when found, 0 when the chunk lives in another
+ * part and -1 on error. */
+static int find_chunk_in_part(PartHandle h, uint32_t chunk_index, const uint8_t** out_src, uint16_t* out_len,
+                              uint8_t* out_split_kind, char* err, size_t err_len)
+{
+	PartView v;
+	if (!part_view(h, &v, err, err_len))
+		return -1;
+	if (chunk_index < v.first_chunk || chunk_index - v.first_chunk >= v.chunk_count)
+		return 0;
+
+	const uint8_t* ent = v.table + ((chunk_index - v.first_chunk) * NTX_PART_ENTRY_SIZE);
+	uint16_t rel = read_u16_le(ent + 0);
+	uint16_t clen = read_u16_le(ent + 2);
+	if ((size_t)rel + clen > v.payload_size)
+	{
+		set_err(err, err_len, "chunk payload out of bounds");
+		return -1;
+	}
+	*out_src = v.payload + rel;
+	*out_len = clen;
+	*out_split_kind = ent[4];
+	return 1;
+}
+
+/* Walks the note's parts for the chunk and leaves the part holding it open. */
+static bool locate_chunk(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, PartHandle* out_h,
+                         const uint8_t** out_src, uint16_t* out_len, uint8_t* out_split_kind, char* err,
+                         size_t err_len)
+{
+	if (chunk_index >= note->total_chunks)
 	{
 		set_err(err, err_len, "chunk out of range");
 		return false;
@@ -221,87 +671,348 @@ bool ntx_load_chunk_text(const NtxNoteEntry* note, uint16_t global_chunk_index,
 
 	for (uint16_t p = 0; p < note->part_count; ++p)
 	{
+		const uint16_t part_id = (uint16_t)(note->first_part_id + p);
 		char name[9] = { 0 };
-		ntx_part_name_from_id((uint16_t)(note->first_part_id + p), name);
-
-		uint8_t* buf = NULL;
-		uint16_t len = 0;
-		if (!read_appvar_bytes(name, &buf, &len, err, err_len))
-			return false;
+		ntx_part_name_from_id(index->prefix, part_id, name);
 
-		if (len < NTX_PART_HEADER_SIZE || memcmp(buf, NTX_MAGIC_PART, 4) != 0)
+		NTX_TRACE_BEGIN(t_read);
+		PartHandle h = part_open(part_id, name);
+		if (!h)
 		{
-			free(buf);
-			set_err(err, err_len, "bad part header");
+			NTX_TRACE_SPAN(NTX_EV_PART_READ, part_id, 0, t_read);
+			set_err_name(err, err_len, "open fail: ", name);
 			return false;
 		}
+		const int found = find_chunk_in_part(h, chunk_index, out_src, out_len, out_split_kind, err, err_len);
+		NTX_TRACE_SPAN(NTX_EV_PART_READ, part_id, (found > 0) ? *out_len : ((found == 0) ? NTX_PART_HEADER_SIZE : 0),
+		               t_read);
+		if (found > 0)
+		{
+			*out_h = h;
+			return true;
+		}
+		part_close(h);
+		if (found < 0)
+			return false;
+	}
 
-		uint16_t version = read_u16_le(buf + 4);
-		uint16_t header_size = read_u16_le(buf + 6);
-		uint16_t chunk_count = read_u16_le(buf + 14);
-		uint16_t chunk_table_off = read_u16_le(buf + 16);
-		uint16_t payload_off = read_u16_le(buf + 18);
-		uint16_t payload_size = read_u16_le(buf + 20);
+	set_err(err, err_len, "chunk not found");
+	return false;
+}
 
-		if (version != 1 || header_size != NTX_PART_HEADER_SIZE)
+static bool is_dict_code(uint8_t c)
+{
+	return c < 0x20U && c != '\t' && c != '\n' && c != '\r';
+}
+
+#ifndef NTX_EMBEDDED
+
+/* Points the reader at the pack dictionary, read in place. */
+static bool open_dict(const NtxIndex* index, NtxChunkReader* r, char* err, size_t err_len)
+{
+	char name[9];
+	snprintf(name, sizeof(name), "%sDIC", index->prefix);
+	r->dict_var = ti_Open(name, "r");
+	if (!r->dict_var)
+	{
+		set_err_name(err, err_len, "open fail: ", name);
+		return false;
+	}
+	const uint8_t* dict = (const uint8_t*)ti_GetDataPtr(r->dict_var);
+	const uint16_t size = ti_GetSize(r->dict_var);
+	if (!dict || size < NTX_DICT_HEADER_SIZE || memcmp(dict, NTX_MAGIC_DICT, 4) != 0 ||
+	    read_u16_le(dict + 4) != NTX_DICT_VERSION || read_u16_le(dict + 6) != NTX_DICT_HEADER_SIZE ||
+	    read_u16_le(dict + 8) != index->dict_count)
+	{
+		set_err(err, err_len, "bad dictionary header");
+		return false;
+	}
+	const uint16_t table_off = read_u16_le(dict + 10);
+	const uint16_t payload_off = read_u16_le(dict + 12);
+	const uint16_t payload_size = read_u16_le(dict + 14);
+	if ((size_t)table_off + ((size_t)index->dict_count * NTX_DICT_ENTRY_SIZE) > size ||
+	    (size_t)payload_off + payload_size > size)
+	{
+		set_err(err, err_len, "dictionary out of bounds");
+		return false;
+	}
+	r->dict_table = dict + table_off;
+	r->dict_payload = dict + payload_off;
+	r->dict_payload_size = payload_size;
+	r->dict_count = index->dict_count;
+	return true;
+}
+
+#endif
+
+bool ntx_chunk_open(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, NtxChunkReader* r,
+                    char* err, size_t err_len)
+{
+	if (!index || !note || !r)
+	{
+		set_err(err, err_len, "bad args");
+		return false;
+	}
+	memset(r, 0, sizeof(*r));
+	PartHandle h;
+	if (!locate_chunk(index, note, chunk_index, &h, &r->src, &r->src_left, &r->split_kind, err, err_len))
+		return false;
+#ifdef NTX_EMBEDDED
+	/* The packer leaves compiled-in packs uncoded. */
+	part_close(h);
+#else
+	r->part_var = h;
+	if (index->dict_count && !open_dict(index, r, err, err_len))
+	{
+		ntx_chunk_close(r);
+		return false;
+	}
+#endif
+	return true;
+}
+
+int ntx_chunk_read(NtxChunkReader* r, char* dst, uint16_t cap)
+{
+	uint16_t n = 0;
+	while (n < cap)
+	{
+		if (r->pending_left)
 		{
-			free(buf);
-			set_err(err, err_len, "part version mismatch");
-			return false;
+			const uint16_t k = (r->pending_left < cap - n) ? r->pending_left : (uint16_t)(cap - n);
+			memcpy(dst + n, r->pending, k);
+			r->pending += k;
+			r->pending_left = (uint16_t)(r->pending_left - k);
+			n = (uint16_t)(n + k);
+			continue;
 		}
-		if ((size_t)payload_off + payload_size > len)
+		if (!r->src_left)
+			break;
+
+		/* Without a dictionary every byte is text. */
+		const uint16_t room = (r->src_left < cap - n) ? r->src_left : (uint16_t)(cap - n);
+		uint16_t run = r->dict_count ? 0 : room;
+		while (run < room && !is_dict_code(r->src[run]))
+			run++;
+		if (run)
 		{
-			free(buf);
-			set_err(err, err_len, "part payload out of bounds");
-			return false;
+			memcpy(dst + n, r->src, run);
+			r->src += run;
+			r->src_left = (uint16_t)(r->src_left - run);
+			n = (uint16_t)(n + run);
+			continue;
 		}
-		if ((size_t)chunk_table_off + ((size_t)chunk_count * NTX_PART_ENTRY_SIZE) > len)
+
+		const uint8_t c = r->src[0];
+		uint16_t id;
+		uint16_t used = 1;
+		if (c == NTX_DICT_REF)
 		{
-			free(buf);
-			set_err(err, err_len, "part chunk table out of bounds");
-			return false;
+			used = 3;
+			id = (r->src_left < used) ? 0xFFFFU
+			                          : (uint16_t)(((r->src[1] & 0x7FU) << 7) | (r->src[2] & 0x7FU));
 		}
-
-		for (uint16_t c = 0; c < chunk_count; ++c)
+		else if (c == NTX_DICT_TOKEN)
+		{
+			used = 2;
+			id = (r->src_left < used || r->src[1] == 0) ? 0xFFFFU
+			                                            : (uint16_t)(NTX_DICT_SHORT_CODES - 1U + r->src[1]);
+		}
+		else
+		{
+			id = (c < 0x03U) ? 0xFFFFU : (uint16_t)(c - 0x03U - (c > '\t') - (c > '\n') - (c > '\r'));
+		}
+		if (id >= r->dict_count)
+		{
+			r->error = "bad dictionary code";
+			return -1;
+		}
+		const uint8_t* ent = r->dict_table + (id * NTX_DICT_ENTRY_SIZE);
+		const uint16_t off = read_u16_le(ent);
+		const uint16_t len = read_u16_le(ent + 2);
+		if ((size_t)off + len > r->dict_payload_size)
 		{
-			const uint8_t* ent = buf + chunk_table_off + ((size_t)c * NTX_PART_ENTRY_SIZE);
-			uint16_t rel = read_u16_le(ent + 0);
-			uint16_t clen = read_u16_le(ent + 2);
-			uint8_t split_kind = ent[4];
-			uint16_t gidx = read_u16_le(ent + 6);
+			r->error = "dictionary entry out of bounds";
+			return -1;
+		}
+		r->pending = r->dict_payload + off;
+		r->pending_left = len;
+		r->src += used;
+		r->src_left = (uint16_t)(r->src_left - used);
+		r->codes++;
+	}
+	return (int)n;
+}
 
-			if (gidx != global_chunk_index)
-				continue;
+void ntx_chunk_close(NtxChunkReader* r)
+{
+	if (!r)
+		return;
+#ifndef NTX_EMBEDDED
+	if (r->part_var)
+		part_close(r->part_var);
+	if (r->dict_var)
+		ti_Close(r->dict_var);
+#endif
+	r->part_var = 0;
+	r->dict_var = 0;
+}
 
-			if ((size_t)rel + clen > payload_size)
+bool ntx_load_chunk_text(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, char* buf,
+                         uint16_t buf_size, const char** out_text, uint16_t* out_len, uint8_t* out_split_kind,
+                         char* err, size_t err_len)
+{
+	if (!index || !note || !out_text || !out_len)
+	{
+		set_err(err, err_len, "bad args");
+		return false;
+	}
+#ifndef NTX_EMBEDDED
+	if (!buf || buf_size == 0)
+	{
+		set_err(err, err_len, "bad args");
+		return false;
+	}
+#endif
+	*out_text = NULL;
+	*out_len = 0;
+	if (out_split_kind)
+		*out_split_kind = 0;
+
+#ifdef NTX_EMBEDDED
+	/* Compiled-in chunks are NUL-terminated and formatted in place. */
+	(void)buf;
+	(void)buf_size;
+	PartHandle h;
+	const uint8_t* src = NULL;
+	uint16_t len = 0;
+	uint8_t split_kind = 0;
+	if (!locate_chunk(index, note, chunk_index, &h, &src, &len, &split_kind, err, err_len))
+		return false;
+	const bool terminated = (size_t)(src - h->data) + len < h->size && src[len] == '\0';
+	part_close(h);
+	if (!terminated)
+	{
+		set_err(err, err_len, "chunk not terminated");
+		return false;
+	}
+	*out_text = (const char*)src;
+	*out_len = len;
+#else
+	NtxChunkReader r;
+	if (!ntx_chunk_open(index, note, chunk_index, &r, err, err_len))
+		return false;
+	const uint8_t split_kind = r.split_kind;
+	NTX_TRACE_BEGIN(t_dict);
+	const int n = ntx_chunk_read(&r, buf, (uint16_t)(buf_size - 1U));
+	const bool whole = n >= 0 && !r.src_left && !r.pending_left;
+	if (r.codes || n < 0)
+		NTX_TRACE_SPAN(NTX_EV_DICT_READ, r.codes, (n >= 0) ? n : 0, t_dict);
+	ntx_chunk_close(&r);
+	if (n < 0)
+	{
+		set_err(err, err_len, r.error);
+		return false;
+	}
+	if (!whole)
+	{
+		NTX_TRACE_OOM(NTX_OOM_CHUNK_TEXT, (size_t)buf_size + 1U);
+		set_err(err, err_len, "chunk exceeds buffer");
+		return false;
+	}
+	buf[n] = '\0';
+	*out_text = buf;
+	*out_len = (uint16_t)n;
+#endif
+	if (out_split_kind)
+		*out_split_kind = split_kind;
+	return true;
+}
+
+/* Sums chunk heights across the note's part tables and fills *out for
+ * chunk_index or, when that is UINT32_MAX, for the chunk covering y. */
+static bool place_chunk(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, uint32_t y,
+                        NtxChunkPlace* out, char* err, size_t err_len)
+{
+	memset(out, 0, sizeof(*out));
+	if (!index || !note)
+	{
+		set_err(err, err_len, "bad args");
+		return false;
+	}
+	if (chunk_index != UINT32_MAX && chunk_index >= note->total_chunks)
+	{
+		set_err(err, err_len, "chunk out of range");
+		return false;
+	}
+
+	NtxChunkPlace last = { 0 };
+	bool found = false;
+	uint32_t sum = 0;
+	for (uint16_t p = 0; p < note->part_count; ++p)
+	{
+		const uint16_t part_id = (uint16_t)(note->first_part_id + p);
+		char name[9] = { 0 };
+		ntx_part_name_from_id(index->prefix, part_id, name);
+
+		NTX_TRACE_BEGIN(t_read);
+		PartHandle h = part_open(part_id, name);
+		PartView v;
+		if (!h || !part_view(h, &v, err, err_len))
+		{
+			NTX_TRACE_SPAN(NTX_EV_PART_READ, part_id, 0, t_read);
+			if (h)
+				part_close(h);
+			else
+				set_err_name(err, err_len, "open fail: ", name);
+			return false;
+		}
+		for (uint16_t i = 0; i < v.chunk_count; ++i)
+		{
+			const uint16_t height = read_u16_le(v.table + (i * NTX_PART_ENTRY_SIZE) + 6);
+			if (height == 0)
 			{
-				free(buf);
-				set_err(err, err_len, "chunk payload out of bounds");
-				return false;
+				/* Packed without --format-dry-run: nothing to place by. */
+				part_close(h);
+				memset(out, 0, sizeof(*out));
+				NTX_TRACE_SPAN(NTX_EV_PART_READ, part_id, NTX_PART_HEADER_SIZE, t_read);
+				return true;
 			}
-
-			char* text = (char*)malloc((size_t)clen + 1U);
-			if (!text)
+			last.chunk = v.first_chunk + i;
+			last.top = sum;
+			last.height = height;
+			sum += height;
+			if (!found && (last.chunk == chunk_index || (chunk_index == UINT32_MAX && y < sum)))
 			{
-				free(buf);
-				set_err(err, err_len, "oom chunk");
-				return false;
+				*out = last;
+				found = true;
 			}
-
-			memcpy(text, buf + payload_off + rel, clen);
-			text[clen] = '\0';
-			free(buf);
-
-			*out_text = text;
-			*out_len = clen;
-			if (out_split_kind)
-				*out_split_kind = split_kind;
-			return true;
 		}
+		part_close(h);
+		NTX_TRACE_SPAN(NTX_EV_PART_READ, part_id, NTX_PART_HEADER_SIZE + (v.chunk_count * NTX_PART_ENTRY_SIZE),
+		               t_read);
+	}
 
-		free(buf);
+	if (!found)
+	{
+		if (chunk_index != UINT32_MAX || sum == 0)
+		{
+			set_err(err, err_len, "chunk not found");
+			return false;
+		}
+		*out = last;
 	}
+	out->note_height = sum;
+	return true;
+}
 
-	set_err(err, err_len, "chunk not found");
-	return false;
+bool ntx_chunk_place(const NtxIndex* index, const NtxNoteEntry* note, uint32_t chunk_index, NtxChunkPlace* out,
+                     char* err, size_t err_len)
+{
+	return place_chunk(index, note, chunk_index, 0, out, err, err_len);
+}
+
+bool ntx_chunk_place_at(const NtxIndex* index, const NtxNoteEntry* note, uint32_t y, NtxChunkPlace* out, char* err,
+                        size_t err_len)
+{
+	return place_chunk(index, note, UINT32_MAX, y, out, err, err_len);
 }
@@ -0,0 +1,233 @@
+#include "ntx_perf.h"
+
+#ifdef NTX_TIMING
+
+#include <fileioc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/timers.h>
+
+#define NTX_PERF_TIMER 1
+
+static uint32_t s_last[NTX_PHASE_COUNT];
+
+#ifdef NTX_PERF
+
+#define NTX_PERF_APPVAR "NTXPERF"
+#define NTX_PERF_MAGIC "NTXF"
+#define NTX_PERF_VERSION 1U
+#define NTX_PERF_HEADER_SIZE 18U
+#define NTX_PERF_PHASE_SIZE 52U
+#define NTX_PERF_EVENT_SIZE 8U
+#define NTX_PERF_BUCKETS 16U
+#define NTX_PERF_MAX_EVENTS 256U
+
+/* CEmu's debug console; writes are ignored on hardware. */
+#ifdef __TICE__
+#define perf_console(...) sprintf((char*)0xFB0000, __VA_ARGS__)
+#else
+#include <debug.h>
+#define perf_console(...) dbg_printf(__VA_ARGS__)
+#endif
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint16_t hist[NTX_PERF_BUCKETS];
+} PerfPhase;
+
+typedef struct
+{
+	uint8_t phase;
+	uint16_t tag;
+	uint32_t cycles;
+} PerfEvent;
+
+static PerfPhase s_phases[NTX_PHASE_COUNT];
+static PerfEvent s_events[NTX_PERF_MAX_EVENTS];
+static uint16_t s_event_count;
+static uint16_t s_events_dropped;
+static uint16_t s_tag;
+
+/* Per-frame phases are only summarised; everything else is also logged so
+ * each open can be attributed to the chunk it loaded. */
+static bool phase_logged(NtxPerfPhase phase)
+{
+	return phase != NTX_PHASE_MENU_FRAME && phase != NTX_PHASE_FRAME && phase != NTX_PHASE_TEX_DRAW &&
+	       phase != NTX_PHASE_SWAP;
+}
+
+/* Bucket b holds samples below 1024 << b cycles; the last one is open-ended. */
+static uint8_t bucket_for(uint32_t cycles)
+{
+	uint8_t b = 0;
+	cycles >>= 10;
+	while (cycles && b < NTX_PERF_BUCKETS - 1U)
+	{
+		cycles >>= 1;
+		b++;
+	}
+	return b;
+}
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+	p = put_u16(p, (uint16_t)v);
+	return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static void stats_reset(void)
+{
+	memset(s_phases, 0, sizeof(s_phases));
+	s_event_count = 0;
+	s_events_dropped = 0;
+	s_tag = 0;
+}
+
+static void stats_record(NtxPerfPhase phase, uint32_t cycles)
+{
+	PerfPhase* p = &s_phases[phase];
+	if (p->count == 0 || cycles < p->min)
+		p->min = cycles;
+	if (cycles > p->max)
+		p->max = cycles;
+	p->count++;
+	p->total += cycles;
+	uint16_t* bucket = &p->hist[bucket_for(cycles)];
+	if (*bucket != 0xFFFFu)
+		(*bucket)++;
+
+	if (!phase_logged(phase))
+		return;
+	if (s_event_count >= NTX_PERF_MAX_EVENTS)
+	{
+		if (s_events_dropped != 0xFFFFu)
+			s_events_dropped++;
+		return;
+	}
+	s_events[s_event_count].phase = (uint8_t)phase;
+	s_events[s_event_count].tag = s_tag;
+	s_events[s_event_count].cycles = cycles;
+	s_event_count++;
+}
+
+void ntx_perf_set_tag(uint16_t tag)
+{
+	s_tag = tag;
+}
+
+static void console_dump(const uint8_t* data, size_t len)
+{
+	char line[80];
+	for (size_t off = 0; off < len; off += 32U)
+	{
+		size_t n = len - off;
+		if (n > 32U)
+			n = 32U;
+		int pos = snprintf(line, sizeof(line), "NTXPERF %04x ", (unsigned int)off);
+		for (size_t i = 0; i < n; ++i)
+			pos += snprintf(line + pos, sizeof(line) - (size_t)pos, "%02x", data[off + i]);
+		perf_console("%s\n", line);
+	}
+	perf_console("NTXPERF end %u\n", (unsigned int)len);
+}
+
+bool ntx_perf_flush(void)
+{
+	static uint8_t buf[NTX_PERF_HEADER_SIZE + (NTX_PHASE_COUNT * NTX_PERF_PHASE_SIZE) +
+	                   (NTX_PERF_MAX_EVENTS * NTX_PERF_EVENT_SIZE)];
+	uint8_t* p = buf;
+
+	memcpy(p, NTX_PERF_MAGIC, 4);
+	p += 4;
+	p = put_u16(p, NTX_PERF_VERSION);
+	p = put_u16(p, NTX_PERF_HEADER_SIZE);
+	p = put_u32(p, NTX_PERF_CLOCK_HZ);
+	*p++ = NTX_PHASE_COUNT;
+	*p++ = NTX_PERF_BUCKETS;
+	p = put_u16(p, s_event_count);
+	p = put_u16(p, s_events_dropped);
+
+	for (unsigned int i = 0; i < NTX_PHASE_COUNT; ++i)
+	{
+		const PerfPhase* ph = &s_phases[i];
+		p = put_u32(p, ph->count);
+		p = put_u32(p, ph->min);
+		p = put_u32(p, ph->max);
+		p = put_u32(p, (uint32_t)ph->total);
+		p = put_u32(p, (uint32_t)(ph->total >> 32));
+		for (unsigned int b = 0; b < NTX_PERF_BUCKETS; ++b)
+			p = put_u16(p, ph->hist[b]);
+	}
+	for (uint16_t i = 0; i < s_event_count; ++i)
+	{
+		*p++ = s_events[i].phase;
+		*p++ = 0;
+		p = put_u16(p, s_events[i].tag);
+		p = put_u32(p, s_events[i].cycles);
+	}
+
+	const size_t len = (size_t)(p - buf);
+	console_dump(buf, len);
+
+	uint8_t h = ti_Open(NTX_PERF_APPVAR, "w");
+	if (!h)
+		return false;
+	const bool ok = ti_Write(buf, 1, len, h) == len;
+	ti_Close(h);
+	return ok;
+}
+
+#else
+
+void ntx_perf_set_tag(uint16_t tag)
+{
+	(void)tag;
+}
+
+#endif /* NTX_PERF */
+
+void ntx_perf_init(void)
+{
+	memset(s_last, 0, sizeof(s_last));
+#ifdef NTX_PERF
+	stats_reset();
+#endif
+
+	timer_Disable(NTX_PERF_TIMER);
+	timer_Set(NTX_PERF_TIMER, 0);
+	timer_Enable(NTX_PERF_TIMER, TIMER_CPU, TIMER_NOINT, TIMER_UP);
+}
+
+uint32_t ntx_perf_now(void)
+{
+	return timer_Get(NTX_PERF_TIMER);
+}
+
+void ntx_perf_record(NtxPerfPhase phase, uint32_t start)
+{
+	if ((unsigned)phase >= NTX_PHASE_COUNT)
+		return;
+	const uint32_t cycles = ntx_perf_now() - start;
+	s_last[phase] = cycles;
+#ifdef NTX_PERF
+	stats_record(phase, cycles);
+#endif
+}
+
+uint32_t ntx_perf_last(NtxPerfPhase phase)
+{
+	return ((unsigned)phase < NTX_PHASE_COUNT) ? s_last[phase] : 0;
+}
+
+#endif /* NTX_TIMING */
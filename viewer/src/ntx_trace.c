@@ -0,0 +1,140 @@
+#include "ntx_trace.h"
+
+#include "ntx_mem.h"
+
+#ifdef NTX_TRACE
+
+#include <fileioc.h>
+#include <string.h>
+#include <sys/timers.h>
+
+#define NTX_TRACE_APPVAR "NTXTRACE"
+#define NTX_TRACE_MAGIC "NTXT"
+#define NTX_TRACE_VERSION 1U
+#define NTX_TRACE_HEADER_SIZE 20U
+#define NTX_TRACE_RECORD_SIZE 12U
+#define NTX_TRACE_CAPACITY 256U
+#define NTX_TRACE_TIMER 2
+#define NTX_TRACE_TICK_HZ 32768UL
+
+typedef struct
+{
+	uint32_t t;
+	uint16_t dur;
+	uint8_t type;
+	uint16_t a;
+	uint16_t b;
+} TraceRecord;
+
+static TraceRecord s_ring[NTX_TRACE_CAPACITY];
+static uint16_t s_head;
+static uint32_t s_total;
+
+void ntx_trace_init(void)
+{
+	s_head = 0;
+	s_total = 0;
+	timer_Disable(NTX_TRACE_TIMER);
+	timer_Set(NTX_TRACE_TIMER, 0);
+	timer_Enable(NTX_TRACE_TIMER, TIMER_32K, TIMER_NOINT, TIMER_UP);
+}
+
+uint32_t ntx_trace_now(void)
+{
+	return timer_Get(NTX_TRACE_TIMER);
+}
+
+static void push(NtxTraceEvent type, uint16_t a, uint16_t b, uint32_t t, uint32_t dur)
+{
+	TraceRecord* r = &s_ring[s_head];
+	r->t = t;
+	r->dur = (dur > 0xFFFFu) ? 0xFFFFu : (uint16_t)dur;
+	r->type = (uint8_t)type;
+	r->a = a;
+	r->b = b;
+	s_head = (uint16_t)((s_head + 1U) % NTX_TRACE_CAPACITY);
+	s_total++;
+}
+
+void ntx_trace_event(NtxTraceEvent type, uint16_t a, uint16_t b)
+{
+	push(type, a, b, ntx_trace_now(), 0);
+}
+
+void ntx_trace_span(NtxTraceEvent type, uint16_t a, uint16_t b, uint32_t start)
+{
+	push(type, a, b, start, ntx_trace_now() - start);
+}
+
+static uint16_t saturate_u16(size_t v)
+{
+	return (v > 0xFFFFu) ? 0xFFFFu : (uint16_t)v;
+}
+
+void ntx_trace_oom(NtxOomSite site, size_t size)
+{
+	push(NTX_EV_OOM, (uint16_t)site, saturate_u16(size), ntx_trace_now(), 0);
+	NTX_TRACE_HEAP();
+}
+
+#ifdef NTX_MEM_TRACK
+void ntx_trace_heap(void)
+{
+	NtxMemStats st;
+	ntx_mem_stats(&st);
+	push(NTX_EV_HEAP, saturate_u16(st.live_total), saturate_u16(st.high_water), ntx_trace_now(), 0);
+}
+#endif
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+	p = put_u16(p, (uint16_t)v);
+	return put_u16(p, (uint16_t)(v >> 16));
+}
+
+/* Writes the ring oldest-first. Streamed record by record so the flush needs
+ * no buffer of its own. */
+bool ntx_trace_flush(void)
+{
+	const uint16_t count = (s_total < NTX_TRACE_CAPACITY) ? (uint16_t)s_total : (uint16_t)NTX_TRACE_CAPACITY;
+	const uint16_t first = (s_total < NTX_TRACE_CAPACITY) ? 0 : s_head;
+
+	uint8_t h = ti_Open(NTX_TRACE_APPVAR, "w");
+	if (!h)
+		return false;
+
+	uint8_t rec[NTX_TRACE_HEADER_SIZE];
+	uint8_t* p = rec;
+	memcpy(p, NTX_TRACE_MAGIC, 4);
+	p += 4;
+	p = put_u16(p, NTX_TRACE_VERSION);
+	p = put_u16(p, NTX_TRACE_HEADER_SIZE);
+	p = put_u32(p, NTX_TRACE_TICK_HZ);
+	p = put_u16(p, count);
+	p = put_u16(p, NTX_TRACE_CAPACITY);
+	p = put_u32(p, s_total);
+	bool ok = ti_Write(rec, 1, NTX_TRACE_HEADER_SIZE, h) == NTX_TRACE_HEADER_SIZE;
+
+	for (uint16_t i = 0; ok && i < count; ++i)
+	{
+		const TraceRecord* r = &s_ring[(first + i) % NTX_TRACE_CAPACITY];
+		p = put_u32(rec, r->t);
+		p = put_u16(p, r->dur);
+		*p++ = r->type;
+		*p++ = 0;
+		p = put_u16(p, r->a);
+		put_u16(p, r->b);
+		ok = ti_Write(rec, 1, NTX_TRACE_RECORD_SIZE, h) == NTX_TRACE_RECORD_SIZE;
+	}
+	ti_Close(h);
+	return ok;
+}
+
+#endif